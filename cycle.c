@@ -116,12 +116,19 @@ static char rcsid[] = "$Id: cycle.c,v 1.30 1999/07/11 15:43:51 dbader Exp $";
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 #include "mpi.h"
 #include "misc.h"
 #include "cycle.h"
 #include "queue.h"
 #include "mpi-printf.h"
 #include "timing.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
 
 #define N_DEFAULT  (1<<10)
 #define MAXARCS     4
@@ -129,6 +136,109 @@ static char rcsid[] = "$Id: cycle.c,v 1.30 1999/07/11 15:43:51 dbader Exp $";
 
 #define PRINT_MERGESIZE 0
 
+/* Fan-in of the merge tree: a stage merges up to 2^MERGE_FANIN_LOG packs
+   on one rank and eliminates every exit internal to that group at once.
+   The fan-in drops, down to 2, while that many copies of the largest
+   current pack (received packs plus the merged one) would exceed
+   MERGE_FANIN_MAXBYTES */
+#define MERGE_FANIN_LOG      2
+#define MERGE_FANIN_MAXBYTES (256*1024*1024)
+
+/* Lay out the merge tree by greedy heavy-edge matching on the number of
+   trans arcs between ranks (see Merge_Plan), so ranks sharing the most
+   boundary merge first; 0 pairs ranks by their bits.  Only rank pairs
+   that share trans arcs are gathered, so planning costs O(E log E) for
+   E such pairs, not O(NODES^2) */
+#define MERGE_HEAVYEDGE 1
+
+/* Ranks that have already sent their pack help the rank they sent it to
+   (and its other senders) with a dense merge: entrance rows are spread
+   over the team and each elimination broadcasts only entr1's row */
+#define MERGE_TEAM 1
+
+/* Run the merge tree without a reduction after each stage: a rank goes
+   on as soon as its own block is merged, and a rank that finds a cycle
+   tells the others with point to point notices (MPI_TAG_CYCLE).  Ranks
+   that know of a cycle still pass packs along the tree, empty ones, so
+   every send is matched.  The stage fan-ins are fixed from the first
+   packs, and MERGE_TEAM, whose per-stage split is collective, is off */
+#define MERGE_ASYNC 0
+
+/* Send a pack as one message, its size header in front of the data; the
+   receiver sizes it with MPI_Mprobe.  0 sends the header and the data as
+   two messages */
+#define PACK_ONEMSG 1
+
+/* With PACK_ONEMSG, grow the receiving rank's pack to the merged size and
+   receive its senders' packs straight in behind it, then rearrange the
+   merged pack in place, rather than receiving each into its own buffer
+   and copying them all into a new one (peg_ConcatPacks, ExpressMerge) */
+#define MERGE_INPLACE 1
+
+/* With PACK_ONEMSG, send a pack's arcs behind its header and vertex
+   records as messages of up to PACK_CHUNK_INTS ints, all posted at once.
+   MERGE_INPLACE then lands them directly in the merged pack and merges the
+   exits and starts the index while they arrive, indexing each entrance
+   once its arcs are in.  0 sends the pack whole */
+#define PACK_CHUNK_INTS (1<<20)
+
+/* With USE_OPENMP, an elimination that would test at least
+   OMP_MERGE_MINWORK new arcs spreads its (entr0, exit1) pairs over the
+   threads; smaller ones stay on one thread */
+#define OMP_MERGE_MINWORK 4096
+
+/* Build the packed express graph directly from the reach lists instead
+   of going through the linked eGraph_t */
+#define DIRECT_PACK 1
+
+/* Switch a merge over to bitset rows once the combined graph has at
+   least DENSE_MERGE_DENSITY * entrNum * exitNum express arcs, provided
+   the rows fit in DENSE_MERGE_MAXBYTES */
+#define DENSE_MERGE 1
+#define DENSE_MERGE_DENSITY  0.125
+#define DENSE_MERGE_MAXBYTES (64*1024*1024)
+
+/* Carry dead vertices, dead arcs and pending arcs from one merge stage to
+   the next instead of compacting after every merge.  The pack is compacted
+   once tombstones make up LAZY_CLEANUP_DEAD of it, once pending arcs reach
+   LAZY_CLEANUP_PEND of its arcs, or before it is sent */
+#define LAZY_CLEANUP 1
+#define LAZY_CLEANUP_DEAD 0.25
+#define LAZY_CLEANUP_PEND 0.25
+
+/* Eliminate a stage's exits in approximate minimum-fill order (fewest
+   preds x succs first) rather than in exit index order */
+#define ELIM_ORDER 1
+
+/* Drop entrances that lead to no live exit and exits that no live
+   entrance reaches, to a fixed point, after building the pack and after
+   each merge.  The partner of a dropped vertex is then missing at the
+   stage that would have paired them, and is discarded there. */
+#define PRUNE_DEADENDS 1
+
+/* Find the back arcs (those not climbing in label) up front.  Only
+   vertices inside the label windows they span can be on a cycle, so
+   Discovery, the packs and the merge see just those; with no back arcs
+   at all the graph is acyclic and the merge is skipped.  Up to
+   BACKARC_GATHERMAX windows are gathered everywhere, beyond that their
+   hull is used */
+#define BACKARC_PRUNE 1
+#define BACKARC_GATHERMAX (1<<16)
+
+/* Search for cycles through the packed express graphs with the merge
+   tree (ENGINE_MERGE) or with a distributed trim and colouring SCC
+   search over the exits (ENGINE_SCC).  ENGINE_AUTO takes the SCC search
+   when boundary vertices are at least ENGINE_SCC_BOUNDARY of the input,
+   where the merged packs would grow toward the whole graph at the root.
+   ENGINE_PEEL skips the express graphs and runs an asynchronous Kahn
+   peeling of the input itself, which suits inputs that are mostly DAG */
+#define ENGINE_MERGE 0
+#define ENGINE_SCC   1
+#define ENGINE_AUTO  2
+#define ENGINE_PEEL  3
+#define CYCLE_ENGINE ENGINE_AUTO
+#define ENGINE_SCC_BOUNDARY 0.25
+
 #if 1
 /* Select Input Here */
 #define Create_Input(n, verts) Create_Input_Lattice(n,verts)
@@ -142,6 +252,10 @@ static char rcsid[] = "$Id: cycle.c,v 1.30 1999/07/11 15:43:51 dbader Exp $";
 BOOL CYCLE_FOUND;
 
 int MYNODE, NODES;
+int MERGENODE;    /* Position of this rank in the merge tree */
+int *mergeRank;   /* Rank at each merge tree position, -1 if none */
+MPI_Comm mergeTeam;  /* Ranks of this rank's merge tree block, this stage */
+int mergeTeamSize;   /* Size of mergeTeam, 1 if there is no team */
 FILE *outfile;
 FILE *errfile;
 
@@ -149,6 +263,10 @@ char *INPUT_GRAPH_NAME;
 
 #define MPI_TAG_SIZES   0
 #define MPI_TAG_DATA    1
+#define MPI_TAG_PEEL    2
+#define MPI_TAG_CYCLE   3
+#define MPI_TAG_PACK    4
+#define MPI_TAG_ARCS    5
 
 #define ENTRV           0
 #define EXITV           1
@@ -177,13 +295,33 @@ static int transArcCompareHead(const void *a, const void *b) {
   return (((transArc_t *)a)->headAssn - ((transArc_t *)b)->headAssn);
 }
 
-static int expGraphLabelCompare(const void *a, const void *b) {
-  return (((labelLookup_t)a)->label - ((labelLookup_t)b)->label);
+#if MERGE_HEAVYEDGE
+static int pairCompareWeight(const void *a, const void *b) {
+  /* (weight, i, j) records: heaviest first, then by i and j */
+  const int *x = (const int *)a;
+  const int *y = (const int *)b;
+  if (x[0] != y[0])
+    return ((x[0] > y[0]) ? -1 : 1);
+  if (x[1] != y[1])
+    return (x[1] - y[1]);
+  return (x[2] - y[2]);
+}
+
+static int pairCompareEnds(const void *a, const void *b) {
+  /* (weight, i, j) records: by i and j */
+  const int *x = (const int *)a;
+  const int *y = (const int *)b;
+  if (x[1] != y[1])
+    return (x[1] - y[1]);
+  return (x[2] - y[2]);
 }
+#endif
 
-static int pArcFlatCompare(const void *a, const void *b) {
-  return (((pArcFlat_t)a)->idx - ((pArcFlat_t)b)->idx);
+#if ENTR_LUT || !EXIT_DIRECT
+static int expGraphLabelCompare(const void *a, const void *b) {
+  return (((labelLookup_t)a)->label - ((labelLookup_t)b)->label);
 }
+#endif
 
 void Create_Input0(int n, vertexList_t *verts) {
   int num;
@@ -240,6 +378,8 @@ void Create_Input0(int n, vertexList_t *verts) {
 
   (*verts)->R = (reachlist_t)SAFE_MALLOC(num*sizeof(struct reachlist_s),
 					 "(cycle.c) (*verts)->R");
+  for (i=0 ; i<num ; i++)
+    ((*verts)->R + i)->next = (reachlist_t)NULL;
   
   return;
 }
@@ -350,6 +490,8 @@ void Create_Input_Lattice(int n, vertexList_t *verts) {
 
   (*verts)->R = (reachlist_t)SAFE_MALLOC(num*sizeof(struct reachlist_s),
 					 "(cycle.c) (*verts)->R");
+  for (i=0 ; i<num ; i++)
+    ((*verts)->R + i)->next = (reachlist_t)NULL;
   
   return;
 }
@@ -416,6 +558,8 @@ void Create_Input_Linear(int n, vertexList_t *verts) {
 
   (*verts)->R = (reachlist_t)SAFE_MALLOC(num*sizeof(struct reachlist_s),
 					 "(cycle.c) (*verts)->R");
+  for (i=0 ; i<num ; i++)
+    ((*verts)->R + i)->next = (reachlist_t)NULL;
   
   return;
 }
@@ -467,6 +611,8 @@ void Create_Input_LocalCycles(int n, vertexList_t *verts) {
 
   (*verts)->R = (reachlist_t)SAFE_MALLOC(num*sizeof(struct reachlist_s),
 					 "(cycle.c) (*verts)->R");
+  for (i=0 ; i<num ; i++)
+    ((*verts)->R + i)->next = (reachlist_t)NULL;
   
   return;
 }
@@ -562,6 +708,136 @@ void visitLocal(vertexList_t verts, int vidx) {
   return;
 }
 
+/*************************************************************************/
+/* Back-arc windows.  An arc (u, v) with label(v) <= label(u) is a back  */
+/* arc, and every other arc climbs in label.  Going around a cycle the   */
+/* labels only fall along its back arcs, so each label on the cycle lies */
+/* in [label(v), label(u)] of one of them.  Arcs touching a vertex       */
+/* outside the union of these windows cannot be on a cycle.              */
+/*************************************************************************/
+
+BOOL Backarc_InWindow(int *win, int winNum, int x) {
+  /* win holds winNum sorted, disjoint [C0, C1] pairs */
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = winNum;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (win[2*mid] <= x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return ((lo > 0) && (x <= win[2*(lo-1)+1]));
+}
+
+int Backarc_Restrict(vertexList_t verts) {
+  /* Drop every arc that cannot lie on a cycle and return the global
+     number of back arcs; with none the graph is acyclic */
+  int i, j, k, myNum, total, winNum;
+  int *myWin, *win, *cnt, *offset;
+  int bound[2], gbound[2];
+  vertex_t v;
+
+  myNum = 0;
+  for (i=0 ; i<verts->num ; i++) {
+    v = verts->vlist + i;
+    for (j=0 ; j<v->arcs ; j++)
+      if (v->alist[j].head <= v->label)
+	myNum++;
+  }
+
+  MPI_Allreduce(&myNum, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  myWin = (int *)SAFE_MALLOC((2*myNum+2)*sizeof(int), "(cycle.c) myWin");
+  k = 0;
+  bound[0] = INT_MAX;
+  bound[1] = INT_MAX;
+  for (i=0 ; i<verts->num ; i++) {
+    v = verts->vlist + i;
+    for (j=0 ; j<v->arcs ; j++) {
+      if (v->alist[j].head <= v->label) {
+	myWin[k++] = v->alist[j].head;
+	myWin[k++] = v->label;
+	if (v->alist[j].head < bound[0])
+	  bound[0] = v->alist[j].head;
+	if (-v->label < bound[1])
+	  bound[1] = -v->label;
+      }
+    }
+  }
+
+  if (total <= BACKARC_GATHERMAX) {
+    /* Few enough to give every node every window */
+    cnt    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) cnt");
+    offset = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) offset");
+    k = 2*myNum;
+    MPI_Allgather(&k, 1, MPI_INT, cnt, 1, MPI_INT, MPI_COMM_WORLD);
+    offset[0] = 0;
+    for (i=1 ; i<NODES ; i++)
+      offset[i] = offset[i-1] + cnt[i-1];
+    win = (int *)SAFE_MALLOC((2*total+2)*sizeof(int), "(cycle.c) win");
+    MPI_Allgatherv(myWin, 2*myNum, MPI_INT,
+		   win, cnt, offset, MPI_INT, MPI_COMM_WORLD);
+    free(offset);
+    free(cnt);
+
+    /* Sort on C0 and coalesce overlapping windows */
+    qsort(win, total, 2*sizeof(int), intCompare);
+    winNum = 0;
+    for (i=0 ; i<total ; i++) {
+      if ((winNum > 0) && (win[2*i] <= win[2*(winNum-1)+1])) {
+	if (win[2*i+1] > win[2*(winNum-1)+1])
+	  win[2*(winNum-1)+1] = win[2*i+1];
+      }
+      else {
+	win[2*winNum]   = win[2*i];
+	win[2*winNum+1] = win[2*i+1];
+	winNum++;
+      }
+    }
+  }
+  else {
+    /* Otherwise one window from the lowest head to the highest tail;
+       the tail is negated so a single MIN reduction finds both */
+    MPI_Allreduce(bound, gbound, 2, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    win = (int *)SAFE_MALLOC(2*sizeof(int), "(cycle.c) win");
+    win[0] = gbound[0];
+    win[1] = -gbound[1];
+    winNum = 1;
+  }
+  free(myWin);
+
+  k = 0;
+  for (i=0 ; i<verts->num ; i++) {
+    v = verts->vlist + i;
+    if (!Backarc_InWindow(win, winNum, v->label)) {
+      k += v->arcs;
+      v->arcs = 0;
+      continue;
+    }
+    myNum = 0;
+    for (j=0 ; j<v->arcs ; j++)
+      if (Backarc_InWindow(win, winNum, v->alist[j].head))
+	v->alist[myNum++] = v->alist[j];
+    k += v->arcs - myNum;
+    v->arcs = myNum;
+  }
+  free(win);
+
+#ifdef DEBUG_PRINT
+  fprintf(outfile,"PE%3d: back arcs: %d windows: %d arcs dropped: %d\n",
+	  MYNODE, total, winNum, k);
+#endif
+#if PRINT_MERGESIZE
+  if (MYNODE==0)
+    fprintf(outfile,"PE%3d: Back arcs: %d\n",MYNODE,total);
+#endif
+
+  return (total);
+}
+
 void Find_Local_Cycles(vertexList_t verts) {
   int i;
   int num;
@@ -891,13 +1167,16 @@ void AddExitVertex(eGraph_t expGraph, transArc_t *tarc) {
   expGraph->exitV        = exitVertex;
   expGraph->exitNum++;
   
+#if !EXIT_DIRECT
   (expGraph->exitLUT + expGraph->exitLUTNum)->label = exitVertex->transArc->tail;
   (expGraph->exitLUT + expGraph->exitLUTNum)->expVertex = exitVertex;
   expGraph->exitLUTNum++;
+#endif
   
   return;
 }
 
+#if ENTR_LUT || !EXIT_DIRECT
 int binSearchLUT(labelLookup_t lut, int minIdx, int maxIdx, int target) {
   /* Search searchList recursively using binary search to find target.
      Return -1 if it does not exist, or target's index if it does. */
@@ -913,6 +1192,7 @@ int binSearchLUT(labelLookup_t lut, int minIdx, int maxIdx, int target) {
   else
     return midIdx;
 }
+#endif
 
 #if ENTR_LUT
 expVertex_t getEntrVertexLUT(eGraph_t expGraph, int label) {
@@ -929,6 +1209,7 @@ expVertex_t getEntrVertexLUT(eGraph_t expGraph, int label) {
 }
 #endif
 
+#if !EXIT_DIRECT
 expVertex_t getExitVertexLUT(eGraph_t expGraph, int label) {
   int idx;
   expVertex_t v;
@@ -941,6 +1222,15 @@ expVertex_t getExitVertexLUT(eGraph_t expGraph, int label) {
   
   return v;
 }
+#endif
+
+#if EXIT_DIRECT
+expVertex_t getExitVertexDirect(vertexList_t verts, eGraph_t expGraph,
+				int label) {
+  /* Exit vertices are local, so their label maps to a dense local index */
+  return (expGraph->exitDirect[localIndex(verts, label)]);
+}
+#endif
 
 reachlist_t getReachList(vertexList_t verts, int label) {
   int idx;
@@ -985,7 +1275,11 @@ void AddExpressArcSet(vertexList_t verts, eGraph_t expGraph,
   while (rlist != (reachlist_t)NULL) {
     reachLabelIdx = rlist->idx;
     reachLabel    = globalLabel(verts, reachLabelIdx);
+#if EXIT_DIRECT
+    exitVertex    = getExitVertexDirect(verts, expGraph, reachLabel);
+#else
     exitVertex    = getExitVertexLUT(expGraph, reachLabel);
+#endif
     if (exitVertex == (expVertex_t)NULL)
       fprintf(errfile,"PE%3d: ERROR: getExitVertexLUT returned NULL\n", MYNODE);
 
@@ -1002,8 +1296,10 @@ void SortExpGraphLUT(eGraph_t expGraph) {
   qsort(expGraph->entrLUT, expGraph->entrLUTNum, sizeof(struct labelLookup_s),
 	expGraphLabelCompare);
 #endif
+#if !EXIT_DIRECT
   qsort(expGraph->exitLUT, expGraph->exitLUTNum, sizeof(struct labelLookup_s),
 	expGraphLabelCompare);
+#endif
   return;
 }
 
@@ -1035,18 +1331,32 @@ void Create_Express(vertexList_t verts,
   (*expGraph)->entrLUTNum  = 0;
 #endif
   
+#if !EXIT_DIRECT
   (*expGraph)->exitLUT = (labelLookup_t)
     SAFE_MALLOC(initTransArcCount * sizeof(struct labelLookup_s),
 		"(cycle.c) (*expGraph)->exitLUT");
   (*expGraph)->exitLUTNum  = 0;
+#else
+  (*expGraph)->exitDirect = (expVertex_t *)
+    SAFE_MALLOC(verts->num * sizeof(expVertex_t),
+		"(cycle.c) (*expGraph)->exitDirect");
+  for (i=0 ; i<verts->num ; i++)
+    (*expGraph)->exitDirect[i] = (expVertex_t)NULL;
+#endif
 
   for (i=0 ; i<initTransArcCount ; i++) {
     AddExitVertex(*expGraph, initTransArcs+i);
+#if EXIT_DIRECT
+    (*expGraph)->exitDirect[localIndex(verts, initTransArcs[i].tail)] =
+      (*expGraph)->exitV;
+#endif
   }
 
+#if !EXIT_DIRECT
   if ((*expGraph)->exitLUTNum != initTransArcCount)
     fprintf(errfile,"PE%3d: ERROR: exitLUTNum (%d) != initTransArcCount (%d)\n",
 	    MYNODE, (*expGraph)->exitLUTNum, initTransArcCount);
+#endif
 
   for (i=0 ; i<termTransArcCount ; i++) {
     AddEntrVertex(*expGraph, termTransArcs+i);
@@ -1103,7 +1413,11 @@ void Free_expVertex(expVertex_t v) {
 void Free_Express(eGraph_t expGraph) {
   expVertex_t v, nextv;
 
+#if EXIT_DIRECT
+  free(expGraph->exitDirect);
+#else
   free(expGraph->exitLUT);
+#endif
 #if ENTR_LUT
   free(expGraph->entrLUT);
 #endif
@@ -1349,12 +1663,33 @@ void peg_SetArcNum(pExpGraph_t peg, int idx, BOOL vType, int val) {
 
 int peg_GetArcOffset(pExpGraph_t peg, int idxEntr) {
   int i, offset;
+  if (peg->arcOffset != (int *)NULL)
+    return (peg->arcOffset[idxEntr]);
   offset=0;
   for (i=0 ; i<idxEntr ; i++)
     offset += peg_GetArcNum(peg, i, ENTRV);
   return (peg_GetVSize()*(peg->entrNum + peg->exitNum) + (peg_GetASize()*offset));
 }
 
+void peg_SetArcOffsets(pExpGraph_t peg) {
+  /* Cache the offset of each entrance's express arcs (the arc counts
+     must already be filled in) */
+  int i, offset;
+
+  if (peg->arcOffset != (int *)NULL)
+    free(peg->arcOffset);
+  peg->arcOffset = (int *)SAFE_MALLOC((peg->entrNum+1)*sizeof(int),
+				      "(cycle.c) peg->arcOffset");
+
+  offset = peg_GetVSize()*(peg->entrNum + peg->exitNum);
+  for (i=0 ; i<peg->entrNum ; i++) {
+    peg->arcOffset[i] = offset;
+    offset += peg_GetASize()*peg_GetArcNum(peg, i, ENTRV);
+  }
+  peg->arcOffset[peg->entrNum] = offset;
+  return;
+}
+
 int peg_GetArcHead(pExpGraph_t peg, int idxEntr, int arcnum) {
   int x;
   x = *( peg->data + peg_GetArcOffset(peg, idxEntr) + arcnum);
@@ -1366,26 +1701,432 @@ void peg_SetArcHead(pExpGraph_t peg, int idxEntr, int arcnum, int val) {
   return;
 }
 
-int peg_GetEntrIdx(pExpGraph_t peg, int label, int adj) {
+/*************************************************************************/
+/* Per-merge lookup tables:                                              */
+/*   exit label -> exit indices with that label (multimap)               */
+/*   exit label -> entrances with an express arc to it (reverse adj.)    */
+/*   (entrance label, adj) -> entrance index                             */
+/*************************************************************************/
+
+#define PEG_HASH(x) ((unsigned int)(x) * 2654435761U)
+
+int peg_IndexTableSize(int n) {
+  /* Smallest power of two holding n keys at a load factor of 1/2 */
+  int size;
+  size = 2;
+  while (size < 2*n)
+    size <<= 1;
+  return size;
+}
+
+void peg_IndexGrowLabels(pegIndex_t ix) {
+  /* Double the label table and rehash it.  Exit chains and pred records
+     hang off the slots by index, so they move along unchanged. */
+  unsigned int mask, h;
+  int i, oldSize, *oldKey, *oldExit, *oldPred, *oldLive;
+
+  oldSize = ix->labelSize;
+  oldKey  = ix->labelKey;
+  oldExit = ix->labelExit;
+  oldPred = ix->labelPred;
+  oldLive = ix->labelLive;
+
+  ix->labelSize = 2*oldSize;
+  ix->labelKey  = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycle.c) ix->labelKey");
+  ix->labelExit = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycle.c) ix->labelExit");
+  ix->labelPred = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycle.c) ix->labelPred");
+  ix->labelLive = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycle.c) ix->labelLive");
+  for (i=0 ; i<ix->labelSize ; i++)
+    ix->labelKey[i] = -1;
+
+  mask = (unsigned int)ix->labelSize - 1;
+  for (i=0 ; i<oldSize ; i++)
+    if (oldKey[i] >= 0) {
+      h = PEG_HASH(oldKey[i]) & mask;
+      while (ix->labelKey[h] >= 0)
+	h = (h + 1) & mask;
+      ix->labelKey[h]  = oldKey[i];
+      ix->labelExit[h] = oldExit[i];
+      ix->labelPred[h] = oldPred[i];
+      ix->labelLive[h] = oldLive[i];
+    }
+
+  free(oldLive);
+  free(oldPred);
+  free(oldExit);
+  free(oldKey);
+  return;
+}
+
+int peg_IndexLabelSlot(pegIndex_t ix, int label, BOOL insert) {
+  /* Return the slot of label, inserting it if requested.
+     Returns -1 if the label is absent and not inserted.  An insert that
+     would take the table past half full grows it first, so a probe
+     always reaches an empty slot. */
+  unsigned int mask, h;
+  int probe;
+
+  mask = (unsigned int)ix->labelSize - 1;
+  h = PEG_HASH(label) & mask;
+  for (probe=0 ; ix->labelKey[h] >= 0 ; probe++) {
+    if (ix->labelKey[h] == label)
+      return (int)h;
+    if (probe == ix->labelSize) {
+      fprintf(errfile,"PE%3d: ERROR: label table full (%d slots)\n",
+	      MYNODE, ix->labelSize);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    h = (h + 1) & mask;
+  }
+  if (!insert)
+    return (-1);
+  if (2*(ix->labelNum+1) > ix->labelSize) {
+    peg_IndexGrowLabels(ix);
+    return (peg_IndexLabelSlot(ix, label, TRUE));
+  }
+  ix->labelKey[h]  = label;
+  ix->labelExit[h] = -1;
+  ix->labelPred[h] = -1;
+  ix->labelLive[h] = 0;
+  ix->labelNum++;
+  return (int)h;
+}
+
+void peg_IndexAddPred(pegIndex_t ix, int label, int entrIdx) {
+  int slot, rec;
+
+  if (ix->predNum == ix->predMax) {
+    ix->predMax  = 2*ix->predMax + 16;
+    ix->predEntr = (int *)realloc(ix->predEntr, ix->predMax*sizeof(int));
+    ix->predNext = (int *)realloc(ix->predNext, ix->predMax*sizeof(int));
+    if ((ix->predEntr == (int *)NULL) || (ix->predNext == (int *)NULL))
+      fprintf(errfile,"PE%3d: ERROR: realloc failed in peg_IndexAddPred\n",
+	      MYNODE);
+  }
+
+  slot = peg_IndexLabelSlot(ix, label, TRUE);
+  rec  = ix->predNum++;
+  ix->predEntr[rec]   = entrIdx;
+  ix->predNext[rec]   = ix->labelPred[slot];
+  ix->labelPred[slot] = rec;
+  return;
+}
+
+void peg_IndexAddExit(pExpGraph_t peg, int idx) {
+  pegIndex_t ix;
+  int slot;
+
+  ix = peg->index;
+  if (peg->deadExitMask[idx] == TRUE) {
+    /* Carried over from an earlier stage */
+    ix->exitNext[idx] = -1;
+    return;
+  }
+  slot = peg_IndexLabelSlot(ix, peg_GetLabel(peg, idx, EXITV), TRUE);
+  ix->exitNext[idx]   = ix->labelExit[slot];
+  ix->labelExit[slot] = idx;
+  ix->labelLive[slot]++;
+  return;
+}
+
+void peg_IndexAddEntr(pExpGraph_t peg, int idx) {
+  /* Enter entrance idx in the (label, adj) table, and its express arcs
+     in the reverse adjacency */
+  pegIndex_t ix;
+  pArcSet_t set;
+  unsigned int mask, h;
+  int k, arcnum, head;
+
+  if (peg->deadEntrMask[idx] == TRUE)
+    return;
+
+  ix = peg->index;
+  mask = (unsigned int)ix->entrSize - 1;
+  h = PEG_HASH(peg_GetLabel(peg, idx, ENTRV) ^
+	       PEG_HASH(peg_GetAdj(peg, idx, ENTRV))) & mask;
+  while (ix->entrSlot[h] >= 0)
+    h = (h + 1) & mask;
+  ix->entrSlot[h] = idx;
+
+  arcnum = peg_GetArcNum(peg, idx, ENTRV);
+  for (k=0 ; k<arcnum ; k++) {
+    head = peg_GetArcHead(peg, idx, k);
+    if (head >= 0)
+      peg_IndexAddPred(ix, head, idx);
+  }
+
+  /* Pending arcs carried over from an earlier stage */
+  set = peg->newArcs + idx;
+  for (k=0 ; k<set->size ; k++)
+    if (set->slot[k] >= 0)
+      peg_IndexAddPred(ix, set->slot[k], idx);
+  return;
+}
+
+void peg_BuildExitIndex(pExpGraph_t peg) {
+  /* Allocate the lookup tables and enter the exits; the entrances and
+     their arcs go in with peg_IndexAddEntr */
+  pegIndex_t ix;
+  int i;
+
+  ix = (pegIndex_t)SAFE_MALLOC(sizeof(struct pegIndex_s),
+			       "(cycle.c) peg->index");
+  peg->index = ix;
+
+  /* Arc heads whose exits have all been eliminated still get a slot,
+     so room is left for every arc as well as every exit */
+  ix->labelSize = peg_IndexTableSize(peg->exitNum + peg->arcNum + peg->newArc);
+  ix->labelKey  = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycle.c) ix->labelKey");
+  ix->labelExit = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycle.c) ix->labelExit");
+  ix->labelPred = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycle.c) ix->labelPred");
+  ix->labelLive = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycle.c) ix->labelLive");
+  for (i=0 ; i<ix->labelSize ; i++)
+    ix->labelKey[i] = -1;
+  ix->labelNum  = 0;
+
+  ix->exitNext  = (int *)SAFE_MALLOC((peg->exitNum+1)*sizeof(int),
+				     "(cycle.c) ix->exitNext");
+
+  ix->entrSize  = peg_IndexTableSize(peg->entrNum);
+  ix->entrSlot  = (int *)SAFE_MALLOC(ix->entrSize*sizeof(int),
+				     "(cycle.c) ix->entrSlot");
+  for (i=0 ; i<ix->entrSize ; i++)
+    ix->entrSlot[i] = -1;
+
+  ix->predNum  = 0;
+  ix->predMax  = peg->arcNum + 16;
+  ix->predEntr = (int *)SAFE_MALLOC(ix->predMax*sizeof(int),
+				    "(cycle.c) ix->predEntr");
+  ix->predNext = (int *)SAFE_MALLOC(ix->predMax*sizeof(int),
+				    "(cycle.c) ix->predNext");
+
+  for (i=0 ; i<peg->exitNum ; i++)
+    peg_IndexAddExit(peg, i);
+
+  return;
+}
+
+void peg_BuildIndex(pExpGraph_t peg) {
+  int i;
+
+  peg_BuildExitIndex(peg);
+  for (i=0 ; i<peg->entrNum ; i++)
+    peg_IndexAddEntr(peg, i);
+  return;
+}
+
+void peg_FreeIndex(pExpGraph_t peg) {
+  pegIndex_t ix;
+
+  ix = peg->index;
+  if (ix == (pegIndex_t)NULL)
+    return;
+  free(ix->predNext);
+  free(ix->predEntr);
+  free(ix->entrSlot);
+  free(ix->exitNext);
+  free(ix->labelLive);
+  free(ix->labelPred);
+  free(ix->labelExit);
+  free(ix->labelKey);
+  free(ix);
+  peg->index = (pegIndex_t)NULL;
+  return;
+}
+
+int peg_IndexFirstExit(pExpGraph_t peg, int label) {
+  /* Return an exit index with this label, or -1 if there is none */
+  int slot;
+
+  slot = peg_IndexLabelSlot(peg->index, label, FALSE);
+  if (slot < 0)
+    return (-1);
+  return (peg->index->labelExit[slot]);
+}
+
+/*************************************************************************/
+/* Pending express arcs: one open-addressed set of head labels per       */
+/* entrance, filled by peg_AddArc and consumed by peg_CleanUp            */
+/*************************************************************************/
+
+BOOL peg_ArcSetFind(pArcSet_t set, int label) {
+  unsigned int mask, h;
+
+  if (set->size == 0)
+    return (FALSE);
+  mask = (unsigned int)set->size - 1;
+  h = PEG_HASH(label) & mask;
+  while (set->slot[h] >= 0) {
+    if (set->slot[h] == label)
+      return (TRUE);
+    h = (h + 1) & mask;
+  }
+  return (FALSE);
+}
+
+void peg_ArcSetResize(pArcSet_t set, int size) {
+  /* Rehash the set into size slots (a power of 2) */
+  unsigned int mask, h;
+  int i, oldSize, *oldSlot;
+
+  oldSize = set->size;
+  oldSlot = set->slot;
+  set->size = size;
+  set->slot = (int *)SAFE_MALLOC(set->size*sizeof(int),
+				 "(cycle.c) set->slot");
+  for (i=0 ; i<set->size ; i++)
+    set->slot[i] = -1;
+  mask = (unsigned int)set->size - 1;
+  for (i=0 ; i<oldSize ; i++)
+    if (oldSlot[i] >= 0) {
+      h = PEG_HASH(oldSlot[i]) & mask;
+      while (set->slot[h] >= 0)
+	h = (h + 1) & mask;
+      set->slot[h] = oldSlot[i];
+    }
+  if (oldSlot != (int *)NULL)
+    free(oldSlot);
+  return;
+}
+
+void peg_ArcSetInsert(pArcSet_t set, int label) {
+  /* label must not already be in the set */
+  unsigned int mask, h;
+
+  if (2*(set->num+1) > set->size)
+    peg_ArcSetResize(set, (set->size == 0) ? 8 : 2*set->size);
+
+  mask = (unsigned int)set->size - 1;
+  h = PEG_HASH(label) & mask;
+  while (set->slot[h] >= 0)
+    h = (h + 1) & mask;
+  set->slot[h] = label;
+  set->num++;
+  return;
+}
+
+#ifdef USE_OPENMP
+void peg_ArcSetReserve(pArcSet_t set, int more) {
+  /* Make room for more labels without a resize, so that
+     peg_ArcSetInsertCAS never has to move the slots under other threads */
+  int size;
+
+  if (more == 0)
+    return;
+  size = (set->size == 0) ? 8 : set->size;
+  while (2*(set->num+more) > size)
+    size *= 2;
+  if (size != set->size)
+    peg_ArcSetResize(set, size);
+  return;
+}
+
+BOOL peg_ArcSetInsertCAS(pArcSet_t set, int label) {
+  /* Thread safe insert after peg_ArcSetReserve.  Slots only ever go
+     from -1 to a label, so a probe that meets label has found a copy and
+     a lost compare-and-swap just moves on.  Returns TRUE if this call
+     added label, FALSE if it was already there. */
+  unsigned int mask, h;
+  int cur;
+
+  mask = (unsigned int)set->size - 1;
+  h = PEG_HASH(label) & mask;
+  for (;;) {
+    cur = __atomic_load_n(set->slot + h, __ATOMIC_ACQUIRE);
+    if (cur < 0) {
+      if (__atomic_compare_exchange_n(set->slot + h, &cur, label, FALSE,
+				      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+	__atomic_fetch_add(&set->num, 1, __ATOMIC_RELAXED);
+	return (TRUE);
+      }
+    }
+    if (cur == label)
+      return (FALSE);
+    h = (h + 1) & mask;
+  }
+}
+#endif
+
+void peg_ArcSetClear(pArcSet_t set) {
+  if (set->slot != (int *)NULL)
+    free(set->slot);
+  set->num  = 0;
+  set->size = 0;
+  set->slot = (int *)NULL;
+  return;
+}
+
+void peg_FreeArcSets(pExpGraph_t peg) {
+  int i;
+
+  if (peg->newArcs == (pArcSet_t)NULL)
+    return;
+  for (i=0 ; i<peg->entrNum ; i++)
+    peg_ArcSetClear(peg->newArcs + i);
+  free(peg->newArcs);
+  peg->newArcs = (pArcSet_t)NULL;
+  return;
+}
+
+int peg_FindEntrIdx(pExpGraph_t peg, int label, int adj) {
+  /* Index of the live entrance (label, adj), or -1 if there is none */
   int i;
+  pegIndex_t ix;
+  unsigned int mask, h;
+
+  ix = peg->index;
+  if (ix != (pegIndex_t)NULL) {
+    mask = (unsigned int)ix->entrSize - 1;
+    h = PEG_HASH(label ^ PEG_HASH(adj)) & mask;
+    while ((i = ix->entrSlot[h]) >= 0) {
+      if ((peg_GetLabel(peg, i, ENTRV) == label) &&
+	  (peg_GetAdj(peg, i, ENTRV) == adj) &&
+	  (peg->deadEntrMask[i] == FALSE))
+	return(i);
+      h = (h + 1) & mask;
+    }
+    return (-1);
+  }
   
   for (i=0 ; i<peg->entrNum ; i++) {
     if ((peg_GetLabel(peg, i, ENTRV) == label) &&
-	(peg_GetAdj(peg, i, ENTRV) == adj))
+	(peg_GetAdj(peg, i, ENTRV) == adj) &&
+	(peg->deadEntrMask[i] == FALSE))
       return(i);
   }
-
-  fprintf(errfile,"PE%3d: ERROR: peg_GetEntrIdx()\n",MYNODE);
   return (-1);
 }
 
-void peg_Init(pExpGraph_t peg) {
+int peg_GetEntrIdx(pExpGraph_t peg, int label, int adj) {
+  int i;
+
+  i = peg_FindEntrIdx(peg, label, adj);
+  if (i < 0)
+    fprintf(errfile,"PE%3d: ERROR: peg_GetEntrIdx()\n",MYNODE);
+  return (i);
+}
+
+void peg_InitAux(pExpGraph_t peg) {
+  /* Everything peg_Init sets up but the data itself */
   int i;
-  
-  peg->data    = (int *)SAFE_MALLOC(peg_GetDataInBytes(peg),
-				    "(cycle.c) peg->data");
 
-  peg->newArcs  = (pArc_t)NULL;
+  peg->arcOffset = (int *)NULL;
+  peg->index    = (pegIndex_t)NULL;
+  peg->newArcs  = (pArcSet_t)SAFE_MALLOC((peg->entrNum+1) * sizeof(struct pArcSet_s),
+					 "(cycle.c) peg->newArcs");
+  for (i=0 ; i<peg->entrNum ; i++) {
+    peg->newArcs[i].num  = 0;
+    peg->newArcs[i].size = 0;
+    peg->newArcs[i].slot = (int *)NULL;
+  }
   peg->deadEntr = 0;
   peg->deadExit = 0;
   peg->deadArc  = 0;
@@ -1404,6 +2145,13 @@ void peg_Init(pExpGraph_t peg) {
   return;
 }
 
+void peg_Init(pExpGraph_t peg) {
+  peg->data    = (int *)SAFE_MALLOC(peg_GetDataInBytes(peg),
+				    "(cycle.c) peg->data");
+  peg_InitAux(peg);
+  return;
+}
+
 void peg_SortArcs(pExpGraph_t peg, int idx, BOOL vType) {
   
   switch (vType) {
@@ -1421,6 +2169,78 @@ void peg_SortArcs(pExpGraph_t peg, int idx, BOOL vType) {
   return;
 }
 
+/*************************************************************************/
+/* Exits are kept sorted by the merge stage at which they become         */
+/* internal, highB(MERGENODE ^ adjAssn), so that stage h only visits    */
+/* the front of the exit list.  Compaction and Send/Recv keep the order. */
+/*************************************************************************/
+
+int peg_ExitStage(pExpGraph_t peg, int idx, int h) {
+  /* Stage of exit idx; exits that are already internal count as stage h */
+  return (max(highB(MERGENODE ^ peg_GetAdjAssn(peg, idx, EXITV)), h));
+}
+
+void peg_SortExitsByStage(pExpGraph_t peg) {
+  /* Stable counting sort of a freshly built pack's exit records */
+  int count[8*sizeof(int)+1];
+  int *buf, *exitPtr;
+  int i, s, vs;
+
+  vs = peg_GetVSize();
+  exitPtr = peg->data + vs*peg->entrNum;
+  buf = (int *)SAFE_MALLOC(vs*peg->exitNum*sizeof(int),
+			   "(cycle.c) buf");
+
+  for (s=0 ; s<=8*(int)sizeof(int) ; s++)
+    count[s] = 0;
+  for (i=0 ; i<peg->exitNum ; i++)
+    count[peg_ExitStage(peg, i, 0) + 1]++;
+  for (s=1 ; s<=8*(int)sizeof(int) ; s++)
+    count[s] += count[s-1];
+  for (i=0 ; i<peg->exitNum ; i++) {
+    s = peg_ExitStage(peg, i, 0);
+    memcpy(buf + vs*count[s], exitPtr + vs*i, vs*sizeof(int));
+    count[s]++;
+  }
+  memcpy(exitPtr, buf, vs*peg->exitNum*sizeof(int));
+
+  free(buf);
+  return;
+}
+
+int peg_MergeExits(pExpGraph_t pTemp, pExpGraph_t p0, pExpGraph_t p1, int h) {
+  /* Merge the stage-sorted exits of p0 and p1 into pTemp, whose entrance
+     count must already be set, carrying p0's dead exit marks along.
+     Returns the number of exits in stage h, which lead the list. */
+  int i0, i1, k, s0, s1, vs, stageNum;
+  int *dst;
+
+  vs  = peg_GetVSize();
+  dst = pTemp->data + vs*pTemp->entrNum;
+  i0 = i1 = k = 0;
+  stageNum = 0;
+  while ((i0 < p0->exitNum) || (i1 < p1->exitNum)) {
+    s0 = (i0 < p0->exitNum) ? peg_ExitStage(p0, i0, h) : -1;
+    s1 = (i1 < p1->exitNum) ? peg_ExitStage(p1, i1, h) : -1;
+    if ((s1 < 0) || ((s0 >= 0) && (s0 <= s1))) {
+      memcpy(dst + vs*k, p0->data + vs*(p0->entrNum + i0), vs*sizeof(int));
+      pTemp->deadExitMask[k] = p0->deadExitMask[i0];
+      if (s0 == h)
+	stageNum++;
+      i0++;
+    }
+    else {
+      memcpy(dst + vs*k, p1->data + vs*(p1->entrNum + i1), vs*sizeof(int));
+      pTemp->deadExitMask[k] = p1->deadExitMask[i1];
+      if (s1 == h)
+	stageNum++;
+      i1++;
+    }
+    k++;
+  }
+  return (stageNum);
+}
+
 void Create_ExpressPack(eGraph_t expGraph, pExpGraph_t *pExpGraph) {
   expVertex_t v;
   expArc_t a;
@@ -1467,6 +2287,83 @@ void Create_ExpressPack(eGraph_t expGraph, pExpGraph_t *pExpGraph) {
     k++;
     v = v->next;
   }
+  peg_SortExitsByStage(peg);
+
+  return;
+}
+
+void Create_ExpressPack_Direct(vertexList_t verts,
+			       int initTransArcCount,
+			       transArc_t *initTransArcs,
+			       int termTransArcCount,
+			       transArc_t *termTransArcs,
+			       pExpGraph_t *pExpGraph)
+{
+  /* Build the packed express graph straight from the reach lists.
+     Pass 1 counts the express arcs to size peg->data, and pass 2 fills
+     the vertex records and writes each entrance's arcs in place.
+     Vertices are stored in the same (reverse) order that
+     Create_Express/Create_ExpressPack would produce. */
+  pExpGraph_t peg;
+  transArc_t *tarc;
+  reachlist_t rlist;
+  int *arcPtr, *arcPtr0;
+  int k, arcnum;
+
+  *pExpGraph = (pExpGraph_t)SAFE_MALLOC(sizeof(struct pExpGraph_s),
+					"(cycle.c) *pExpGraph");
+  peg = *pExpGraph;
+
+  peg->entrNum = termTransArcCount;
+  peg->exitNum = initTransArcCount;
+  peg->arcNum  = 0;
+
+  /* Pass 1: count */
+  for (k=0 ; k<termTransArcCount ; k++) {
+    rlist = getReachList(verts, termTransArcs[k].head)->next;
+    while (rlist != (reachlist_t)NULL) {
+      peg->arcNum++;
+      rlist = rlist->next;
+    }
+  }
+
+  peg_Init(peg);
+
+  /* Pass 2: fill */
+  arcPtr = peg->data + peg_GetVSize()*(peg->entrNum + peg->exitNum);
+  for (k=0 ; k<peg->entrNum ; k++) {
+    tarc = termTransArcs + (termTransArcCount - 1 - k);
+    peg_SetLabel  (peg, k, ENTRV, tarc->head);
+    peg_SetAdj    (peg, k, ENTRV, tarc->tail);
+    peg_SetAdjAssn(peg, k, ENTRV, tarc->tailAssn);
+
+    arcPtr0 = arcPtr;
+    rlist = getReachList(verts, tarc->head)->next;
+    while (rlist != (reachlist_t)NULL) {
+      *arcPtr = globalLabel(verts, rlist->idx);
+      arcPtr++;
+      rlist = rlist->next;
+    }
+    arcnum = (int)(arcPtr - arcPtr0);
+    peg_SetArcNum (peg, k, ENTRV, arcnum);
+    qsort(arcPtr0, arcnum, sizeof(int), intCompare);
+  }
+
+  if ((int)(arcPtr - (peg->data + peg_GetVSize()*(peg->entrNum + peg->exitNum)))
+      != peg->arcNum)
+    fprintf(errfile,"PE%3d: ERROR: Create_ExpressPack_Direct arc count mismatch\n",
+	    MYNODE);
+
+  for (k=0 ; k<peg->exitNum ; k++) {
+    tarc = initTransArcs + (initTransArcCount - 1 - k);
+    peg_SetLabel  (peg, k, EXITV, tarc->tail);
+    peg_SetAdj    (peg, k, EXITV, tarc->head);
+    peg_SetAdjAssn(peg, k, EXITV, tarc->headAssn);
+    peg_SetArcNum (peg, k, EXITV, 0);
+  }
+  peg_SortExitsByStage(peg);
+
+  peg_SetArcOffsets(peg);
 
   return;
 }
@@ -1516,15 +2413,11 @@ void Print_ExpressPack(pExpGraph_t peg) {
 }
 
 void Free_ExpressPack(pExpGraph_t peg) {
-  pArc_t a, nexta;
-
-  a = peg->newArcs;
-  while (a != (pArc_t)NULL) {
-    nexta = a->next;
-    free(a);
-    a = nexta;
-  }
 
+  peg_FreeArcSets(peg);
+  peg_FreeIndex(peg);
+  if (peg->arcOffset != (int *)NULL)
+    free(peg->arcOffset);
   free(peg->deadEntrMask);
   free(peg->deadExitMask);
   if (peg->data != (int *)NULL)
@@ -1533,16 +2426,78 @@ void Free_ExpressPack(pExpGraph_t peg) {
   return;
 }
 
+MPI_Datatype Pack_MsgType(int *sizeBuf, int *data, int dataInts) {
+  /* The 3-int size header and the data of a pack, as one message */
+  MPI_Datatype msgType;
+  int          len[2];
+  MPI_Aint     disp[2];
+
+  len[0] = 3;
+  len[1] = dataInts;
+  MPI_Get_address(sizeBuf, disp);
+  MPI_Get_address(data, disp + 1);
+  MPI_Type_create_hindexed(2, len, disp, MPI_INT, &msgType);
+  MPI_Type_commit(&msgType);
+  return (msgType);
+}
+
+int Pack_ChunkNum(int arcInts) {
+  /* Number of messages carrying arcInts ints of arcs */
+#if PACK_CHUNK_INTS > 0
+  return ((arcInts + PACK_CHUNK_INTS - 1) / PACK_CHUNK_INTS);
+#else
+  return (0);
+#endif
+}
+
+int Pack_ChunkInts(int arcInts, int k) {
+  /* Size of the k-th of them */
+  return (min(PACK_CHUNK_INTS, arcInts - k*PACK_CHUNK_INTS));
+}
+
+void Pack_PostArcs(int *arcs, int arcInts, int fromNode, MPI_Request *req) {
+  /* Post the receives for arcInts ints of arcs from fromNode */
+  int k;
+
+  for (k=0 ; k<Pack_ChunkNum(arcInts) ; k++)
+    MPI_Irecv(arcs + k*PACK_CHUNK_INTS, Pack_ChunkInts(arcInts, k), MPI_INT,
+	      fromNode, MPI_TAG_ARCS, MPI_COMM_WORLD, req + k);
+  return;
+}
+
 void Send_ExpressPack(pExpGraph_t peg, int toNode) {
   int sizeBuf[3];
+#if PACK_ONEMSG
+  MPI_Datatype msgType;
+  MPI_Request *req;
+  int arcInts, headInts, chunkNum, k;
+#endif
 
   sizeBuf[0] = peg->entrNum;
   sizeBuf[1] = peg->exitNum;
   sizeBuf[2] = peg->arcNum;
 
+#if PACK_ONEMSG
+  /* Header and vertex records, then the arcs in chunks */
+  arcInts  = (PACK_CHUNK_INTS > 0) ? peg_GetASize()*peg->arcNum : 0;
+  headInts = peg_GetDataInInts(peg) - arcInts;
+  chunkNum = Pack_ChunkNum(arcInts);
+  req = (MPI_Request *)SAFE_MALLOC((chunkNum+1)*sizeof(MPI_Request),
+				   "(cycle.c) req");
+  msgType = Pack_MsgType(sizeBuf, peg->data, headInts);
+  MPI_Isend(MPI_BOTTOM, 1, msgType, toNode, MPI_TAG_PACK, MPI_COMM_WORLD, req);
+  for (k=0 ; k<chunkNum ; k++)
+    MPI_Isend(peg->data + headInts + k*PACK_CHUNK_INTS,
+	      Pack_ChunkInts(arcInts, k), MPI_INT, toNode, MPI_TAG_ARCS,
+	      MPI_COMM_WORLD, req + 1 + k);
+  MPI_Waitall(chunkNum+1, req, MPI_STATUSES_IGNORE);
+  MPI_Type_free(&msgType);
+  free(req);
+#else
   MPI_Send(sizeBuf, 3, MPI_INT, toNode, MPI_TAG_SIZES, MPI_COMM_WORLD);
   MPI_Send(peg->data, peg_GetDataInInts(peg), MPI_INT, toNode, MPI_TAG_DATA,
 	   MPI_COMM_WORLD);
+#endif
   
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: I SENT THIS TO PE%3d\n",MYNODE,toNode);
@@ -1557,11 +2512,46 @@ void Recv_ExpressPack(pExpGraph_t *pExpGraph, int fromNode) {
   pExpGraph_t peg;
   int         sizeBuf[3];
   MPI_Status  mpstat;
+#if PACK_ONEMSG
+  MPI_Message  msg;
+  MPI_Datatype msgType;
+  MPI_Request *req;
+  int          count, arcInts;
+#endif
   
   *pExpGraph = (pExpGraph_t)SAFE_MALLOC(sizeof(struct pExpGraph_s),
 					"(cycle.c) *pExpGraph");
   peg = *pExpGraph;
 
+#if PACK_ONEMSG
+  /* The message size gives the data size; the header comes with it */
+  MPI_Mprobe(fromNode, MPI_TAG_PACK, MPI_COMM_WORLD, &msg, &mpstat);
+  MPI_Get_count(&mpstat, MPI_INT, &count);
+  peg->data = (int *)SAFE_MALLOC((count-3)*sizeof(int),
+				 "(cycle.c) peg->data");
+  msgType = Pack_MsgType(sizeBuf, peg->data, count-3);
+  MPI_Mrecv(MPI_BOTTOM, 1, msgType, &msg, &mpstat);
+  MPI_Type_free(&msgType);
+
+  peg->entrNum = sizeBuf[0];
+  peg->exitNum = sizeBuf[1];
+  peg->arcNum  = sizeBuf[2];
+
+  /* Arcs sent in chunks follow */
+  arcInts = peg_GetDataInInts(peg) - (count-3);
+  if (arcInts > 0) {
+    peg->data = (int *)realloc(peg->data, peg_GetDataInBytes(peg));
+    if (peg->data == (int *)NULL)
+      fprintf(errfile,"PE%3d: ERROR: realloc failed in Recv_ExpressPack\n",
+	      MYNODE);
+    req = (MPI_Request *)SAFE_MALLOC(Pack_ChunkNum(arcInts)*sizeof(MPI_Request),
+				     "(cycle.c) req");
+    Pack_PostArcs(peg->data + count-3, arcInts, fromNode, req);
+    MPI_Waitall(Pack_ChunkNum(arcInts), req, MPI_STATUSES_IGNORE);
+    free(req);
+  }
+  peg_InitAux(peg);
+#else
   MPI_Recv(sizeBuf, 3, MPI_INT, fromNode, MPI_TAG_SIZES, MPI_COMM_WORLD,
 	   &mpstat);
 
@@ -1573,6 +2563,9 @@ void Recv_ExpressPack(pExpGraph_t *pExpGraph, int fromNode) {
   
   MPI_Recv(peg->data, peg_GetDataInInts(peg), MPI_INT, fromNode, MPI_TAG_DATA,
 	   MPI_COMM_WORLD, &mpstat);
+#endif
+
+  peg_SetArcOffsets(peg);
   
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: I RECEIVED THIS FROM PE%3d\n",MYNODE,fromNode);
@@ -1583,28 +2576,74 @@ void Recv_ExpressPack(pExpGraph_t *pExpGraph, int fromNode) {
   return;
 }
 
-int peg_CheckArcHead(pExpGraph_t peg, int idx, int min_idx, int max_idx, int target) {
-  int mid_idx;
-  int midhead;
-  
-  mid_idx = min_idx + (max_idx - min_idx) / 2;
+pExpGraph_t peg_ConcatPacks(pExpGraph_t *pList, int num) {
+  /* One compact pack holding the vertices and arcs of num compact packs,
+     with the exits re-sorted by stage */
+  pExpGraph_t peg;
+  int *ptr;
+  int j, vs, as;
+
+  vs = peg_GetVSize();
+  as = peg_GetASize();
+
+  peg = (pExpGraph_t)SAFE_MALLOC(sizeof(struct pExpGraph_s),
+				 "(cycle.c) peg");
+  peg->entrNum = 0;
+  peg->exitNum = 0;
+  peg->arcNum  = 0;
+  for (j=0 ; j<num ; j++) {
+    peg->entrNum += pList[j]->entrNum;
+    peg->exitNum += pList[j]->exitNum;
+    peg->arcNum  += pList[j]->arcNum;
+  }
+
+  peg_Init(peg);
+
+  ptr = peg->data;
+  for (j=0 ; j<num ; j++) {
+    memcpy(ptr, pList[j]->data, vs*pList[j]->entrNum*sizeof(int));
+    ptr += vs*pList[j]->entrNum;
+  }
+  for (j=0 ; j<num ; j++) {
+    memcpy(ptr, pList[j]->data + vs*pList[j]->entrNum,
+	   vs*pList[j]->exitNum*sizeof(int));
+    ptr += vs*pList[j]->exitNum;
+  }
+  for (j=0 ; j<num ; j++) {
+    memcpy(ptr, pList[j]->data + vs*(pList[j]->entrNum + pList[j]->exitNum),
+	   as*pList[j]->arcNum*sizeof(int));
+    ptr += as*pList[j]->arcNum;
+  }
+
+  peg_SortExitsByStage(peg);
+  peg_SetArcOffsets(peg);
+  return (peg);
+}
+
+int peg_CheckArcHead(pExpGraph_t peg, int idx, int min_idx, int max_idx, int target) {
+  int mid_idx;
+  int midhead;
+  
+  mid_idx = min_idx + (max_idx - min_idx) / 2;
   if (max_idx < min_idx)
     return (-1);
   else {
+    /* Dead arcs are negated in place, so search on the magnitude */
     midhead = peg_GetArcHead(peg, idx, mid_idx);
-    if (target < midhead)
+    if (target < abs(midhead))
       return peg_CheckArcHead(peg, idx, min_idx, mid_idx - 1, target);
     else {
-      if (target > midhead)
+      if (target > abs(midhead))
 	return peg_CheckArcHead(peg, idx, mid_idx + 1, max_idx, target);
       else
-	return (mid_idx);
+	return ((midhead >= 0) ? mid_idx : -1);
     }
   }
 }
 
 void peg_GetEntrPred(pExpGraph_t peg, int label, int *num, int **listPred) {
   int i, n;
+  int slot, rec;
   int arcnum;
   int foundIdx;
   BOOL found;
@@ -1613,6 +2652,23 @@ void peg_GetEntrPred(pExpGraph_t peg, int label, int *num, int **listPred) {
 				 "(cycle.c) *listPred");
 
   n=0;
+  if (peg->index != (pegIndex_t)NULL) {
+    /* Walk the reverse adjacency, which also holds arcs added during
+       this merge; skip entrances that have since been removed */
+    slot = peg_IndexLabelSlot(peg->index, label, FALSE);
+    rec  = (slot >= 0) ? peg->index->labelPred[slot] : -1;
+    while (rec >= 0) {
+      i = peg->index->predEntr[rec];
+      if (peg->deadEntrMask[i] == FALSE) {
+	*(*listPred + n) = i;
+	n++;
+      }
+      rec = peg->index->predNext[rec];
+    }
+    *num = n;
+    return;
+  }
+
   for (i=0 ; i<peg->entrNum ; i++) {
     arcnum = peg_GetArcNum(peg, i, ENTRV);
     foundIdx = peg_CheckArcHead(peg, i, 0, arcnum-1, label);
@@ -1633,7 +2689,6 @@ void peg_GetEntrPred(pExpGraph_t peg, int label, int *num, int **listPred) {
 
 BOOL peg_CheckArc(pExpGraph_t peg, int idx, int arcHeadLabel) {
   int arcnum;
-  pArc_t parc;
   int foundIdx;
   BOOL found;
 
@@ -1641,17 +2696,15 @@ BOOL peg_CheckArc(pExpGraph_t peg, int idx, int arcHeadLabel) {
   foundIdx = peg_CheckArcHead(peg, idx, 0, arcnum-1, arcHeadLabel);
   found = (foundIdx >= 0);
   
-  parc = peg->newArcs;
-  while ((parc != (pArc_t)NULL) && (!found)) {
-    found = ((parc->idx == idx) && (parc->head == arcHeadLabel));
-    parc = parc->next;
-  }
+  if (!found)
+    found = peg_ArcSetFind(peg->newArcs + idx, arcHeadLabel);
   
   return (found);
 }
 
 void peg_RemoveVertex(pExpGraph_t peg, int idx, BOOL vType) {
   int i, arcnum, k, lab_exit;
+  int slot, rec;
   BOOL found;
 #ifdef DEBUG_PRINT
   int lab_entr;
@@ -1667,7 +2720,13 @@ void peg_RemoveVertex(pExpGraph_t peg, int idx, BOOL vType) {
   case ENTRV:
     peg->deadEntr++;
     peg->deadEntrMask[idx] = TRUE;
-    peg->deadArc += peg_GetArcNum(peg, idx, vType);
+    arcnum = peg_GetArcNum(peg, idx, vType);
+    for (k=0 ; k<arcnum ; k++)
+      if (peg_GetArcHead(peg, idx, k) >= 0)
+	peg->deadArc++;
+    /* Pending arcs of a removed entrance are never merged in */
+    peg->newArc  -= peg->newArcs[idx].num;
+    peg_ArcSetClear(peg->newArcs + idx);
 #ifdef DEBUG_PRINT
     fprintf(outfile,"PE%3d: Removing %s vertex \t killing %2d arcs\n",
 	  MYNODE, (vType==ENTRV)?"ENTR":"EXIT", peg_GetArcNum(peg,idx,vType));
@@ -1682,6 +2741,34 @@ void peg_RemoveVertex(pExpGraph_t peg, int idx, BOOL vType) {
     /* If we are the last exit vertex with this label, remove express arcs
        aimed at us */
 
+    if (peg->index != (pegIndex_t)NULL) {
+      /* Drop our label's live count, and if it reaches zero negate the
+	 arcs of the entrances in its reverse adjacency */
+      slot = peg_IndexLabelSlot(peg->index, lab_exit, FALSE);
+      if (slot < 0) {
+	fprintf(errfile,"PE%3d: ERROR: peg_RemoveVertex() label %d not indexed\n",
+		MYNODE, lab_exit);
+	break;
+      }
+      peg->index->labelLive[slot]--;
+      if (peg->index->labelLive[slot] > 0)
+	break;
+      rec = peg->index->labelPred[slot];
+      while (rec >= 0) {
+	i = peg->index->predEntr[rec];
+	if (peg->deadEntrMask[i] == FALSE) {
+	  arcnum = peg_GetArcNum(peg, i, ENTRV);
+	  k = peg_CheckArcHead(peg, i, 0, arcnum-1, lab_exit);
+	  if (k >= 0) {
+	    peg_SetArcHead(peg, i, k, -lab_exit);
+	    peg->deadArc++;
+	  }
+	}
+	rec = peg->index->predNext[rec];
+      }
+      break;
+    }
+
     found = FALSE;
     i=0;
     while ((i<peg->exitNum) && (!found)) {
@@ -1715,319 +2802,1228 @@ void peg_RemoveVertex(pExpGraph_t peg, int idx, BOOL vType) {
 }
 
 void peg_AddArc(pExpGraph_t peg, int idx, int arcHeadLabel) {
-  pArc_t parc;
-
-  parc = (pArc_t)SAFE_MALLOC(sizeof(struct pArc_s),
-			     "(cycle.c) parc");
 
-  parc->idx  = idx;
-  parc->head = arcHeadLabel;
-  parc->next = peg->newArcs;
-
-  peg->newArcs = parc;
+  peg_ArcSetInsert(peg->newArcs + idx, arcHeadLabel);
   peg->newArc++;
 
+  if (peg->index != (pegIndex_t)NULL)
+    peg_IndexAddPred(peg->index, arcHeadLabel, idx);
+
   return;
 }
 
-void peg_CleanUp(pExpGraph_t peg) {
-  /* Merge in the new Express Arcs and delete all vertices with marked labels */
-  pArc_t a, nexta;
-  pArcFlat_t newArcsArr;
-  int k;
-  pExpGraph_t pegNew;
-  int arcIdx, vIdx, i, nextIdx;
-  int totArc, curArc, newArc, idx0, j;
-  int aIdx, alab;
-
-  pegNew = (pExpGraph_t)SAFE_MALLOC(sizeof(struct pExpGraph_s),
-				    "(cycle.c) pegNew");
-  
-  pegNew->entrNum = peg->entrNum - peg->deadEntr;
-  pegNew->exitNum = peg->exitNum - peg->deadExit;
-  pegNew->arcNum  = peg->arcNum  - peg->deadArc + peg->newArc;
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: dead entr: %3d dead exit: %3d dead arc: %3d new arc: %3d\n",
-	  MYNODE, peg->deadEntr, peg->deadExit, peg->deadArc, peg->newArc);
-#endif
-
-  peg_Init(pegNew);
-
-  newArcsArr = (pArcFlat_t)SAFE_MALLOC(peg->newArc * sizeof(struct pArcFlat_s),
-				       "(cycle.c) newArcsArr");
+#ifdef USE_OPENMP
+static int pairIndexCompare(const void *a, const void *b) {
+  long x = *(const long *)a, y = *(const long *)b;
+  return ((x > y) - (x < y));
+}
 
-  k = 0;
-  a = peg->newArcs;
-  while (a != (pArc_t)NULL) {
-    newArcsArr[k].idx  = a->idx;
-    newArcsArr[k].head = a->head;
-    nexta = a->next;
-    free(a);
-    a = nexta;
-    k++;
+int peg_AddArcsOmp(pExpGraph_t peg, int *entr0List, int entr0Num,
+		   int *exit1List, int exit1Num) {
+  /* peg_AddArc for every missing entr0 -> exit1 arc of one elimination.
+     The (entr0, exit1) pairs are spread over the threads, so one arc set
+     takes inserts from several threads at once.  A first sweep counts
+     the arcs each entr0 lacks and reserves just that much room; the
+     second sweep then inserts with peg_ArcSetInsertCAS, which never
+     resizes and drops a duplicate the moment it is offered.  Each thread
+     keeps the pair indices it won.  The reverse adjacency is shared, so
+     these are sorted and indexed afterwards in (entr0, exit1) order.
+     Returns the number of arcs added. */
+  int *exit1Lab, *need;
+  long *won, *myWon;
+  long k, pairNum;
+  int p, s, arcnum, fill, myNum, myMax;
+
+  pairNum  = (long)entr0Num*exit1Num;
+  exit1Lab = (int *)SAFE_MALLOC(exit1Num*sizeof(int), "(cycle.c) exit1Lab");
+  need     = (int *)SAFE_MALLOC(entr0Num*sizeof(int), "(cycle.c) need");
+
+  for (s=0 ; s<exit1Num ; s++)
+    exit1Lab[s] = peg_GetLabel(peg, exit1List[s], EXITV);
+  for (p=0 ; p<entr0Num ; p++)
+    need[p] = 0;
+
+#pragma omp parallel for schedule(dynamic,256) private(p, s)
+  for (k=0 ; k<pairNum ; k++) {
+    p = (int)(k / exit1Num);
+    s = (int)(k % exit1Num);
+    if (!peg_CheckArc(peg, entr0List[p], exit1Lab[s])) {
+#pragma omp atomic
+      need[p]++;
+    }
   }
 
-  if (k != peg->newArc)
-    fprintf(errfile,"PE%3d: ERROR: k (%d) != peg->newArc (%d) \n",
-	    MYNODE, k, peg->newArc);
+  for (p=0 ; p<entr0Num ; p++)
+    peg_ArcSetReserve(peg->newArcs + entr0List[p], need[p]);
 
-  qsort(newArcsArr, k, sizeof(struct pArcFlat_s), pArcFlatCompare);
+  won  = (long *)NULL;
+  fill = 0;
+#pragma omp parallel private(p, s, arcnum, myWon, myNum, myMax)
+  {
+    myWon = (long *)NULL;
+    myNum = 0;
+    myMax = 0;
+#pragma omp for schedule(dynamic,256) nowait
+    for (k=0 ; k<pairNum ; k++) {
+      p = (int)(k / exit1Num);
+      s = (int)(k % exit1Num);
+      if (need[p] == 0)
+	continue;
+      arcnum = peg_GetArcNum(peg, entr0List[p], ENTRV);
+      if ((peg_CheckArcHead(peg, entr0List[p], 0, arcnum-1, exit1Lab[s]) < 0) &&
+	  peg_ArcSetInsertCAS(peg->newArcs + entr0List[p], exit1Lab[s])) {
+	if (myNum == myMax) {
+	  myMax = 2*myMax + 16;
+	  myWon = (long *)realloc(myWon, myMax*sizeof(long));
+	  if (myWon == (long *)NULL)
+	    fprintf(errfile,"PE%3d: ERROR: realloc failed in peg_AddArcsOmp\n",
+		    MYNODE);
+	}
+	myWon[myNum++] = k;
+      }
+    }
+    if (myNum > 0) {
+#pragma omp critical
+      {
+	won = (long *)realloc(won, (fill + myNum)*sizeof(long));
+	if (won == (long *)NULL)
+	  fprintf(errfile,"PE%3d: ERROR: realloc failed in peg_AddArcsOmp\n",
+		  MYNODE);
+	memcpy(won + fill, myWon, myNum*sizeof(long));
+	fill += myNum;
+      }
+    }
+    if (myWon != (long *)NULL)
+      free(myWon);
+  }
 
-#ifdef DEBUG_PRINT
-  for (i=0 ; i<k ; i++)
-    fprintf(outfile,"PE%3d: newArcsArr[%3d]: (%3d, %3d)\n",
-	    MYNODE, i, newArcsArr[i].idx, newArcsArr[i].head);
+  qsort(won, fill, sizeof(long), pairIndexCompare);
+  if (peg->index != (pegIndex_t)NULL)
+    for (k=0 ; k<fill ; k++)
+      peg_IndexAddPred(peg->index, exit1Lab[won[k] % exit1Num],
+		       entr0List[won[k] / exit1Num]);
+  peg->newArc += fill;
+
+  if (won != (long *)NULL)
+    free(won);
+  free(need);
+  free(exit1Lab);
+  return (fill);
+}
 #endif
-  /* CHECK */
 
-  /* Entrance Vertices */
-  arcIdx = 0;
-  vIdx   = 0;
-  
+void peg_CleanUp(pExpGraph_t peg) {
+  /* Merge in the new Express Arcs and delete all vertices with marked
+     labels.  The pack is compacted in place: live records slide down,
+     live arcs are squeezed forward, and then each entrance's block is
+     moved back (last entrance first) to open room for its new arcs. */
+  pArcSet_t set;
+  struct pArcSet_s tmpSet;
+  int i, j, k, vs;
+  int newEntr, newExit, newArcNum, oldInts, newInts;
+  int base, pos, off, num, live, pend;
+
+  vs = peg_GetVSize();
+
+  if (peg->arcOffset == (int *)NULL)
+    peg_SetArcOffsets(peg);
+  oldInts = peg_GetDataInInts(peg);
+
+  newEntr = 0;
+  for (i=0 ; i<peg->entrNum ; i++)
+    if (peg->deadEntrMask[i] == FALSE)
+      newEntr++;
+  newExit = 0;
+  for (i=0 ; i<peg->exitNum ; i++)
+    if (peg->deadExitMask[i] == FALSE)
+      newExit++;
+
+  /* Entrance records, their pending arc sets and old arc offsets */
+  k = 0;
   for (i=0 ; i<peg->entrNum ; i++) {
     if (peg->deadEntrMask[i] == FALSE) {
-      peg_SetLabel  (pegNew, vIdx, ENTRV, peg_GetLabel  (peg, i, ENTRV));
-      peg_SetAdj    (pegNew, vIdx, ENTRV, peg_GetAdj    (peg, i, ENTRV));
-      peg_SetAdjAssn(pegNew, vIdx, ENTRV, peg_GetAdjAssn(peg, i, ENTRV));
-      totArc = peg_GetArcNum(peg, i, ENTRV);
-
-      curArc = 0;
-      for (j=0 ; j<totArc ; j++) {
-	if (peg_GetArcHead(peg, i, j) >= 0)
-	  curArc++;
-      }
-      
-      idx0   = arcIdx;
-      if (arcIdx < k) {
-	nextIdx = newArcsArr[arcIdx].idx;
-	if (nextIdx < i)
-	  fprintf(errfile,"PE%3d: ERROR: newArcs[arcIdx(%d)].idx (%d) < i (%d)\n",
-		  MYNODE, arcIdx, newArcsArr[arcIdx].idx, i);
-	while ((arcIdx<k) && (nextIdx == i)) {
-	  arcIdx++;
-	  if (arcIdx<k)
-	    nextIdx =  newArcsArr[arcIdx].idx;
-	}
-      }
-      newArc = arcIdx - idx0;
-      peg_SetArcNum(pegNew, vIdx, ENTRV, curArc + newArc);
-      aIdx = 0;
-      for (j=0 ; j<totArc ; j++) {
-	alab = peg_GetArcHead(peg, i, j);
-	if (alab >= 0) {
-	  peg_SetArcHead(pegNew, vIdx, aIdx, alab);
-	  aIdx++;
-	}
+      if (k != i) {
+	memmove(peg->data + k*vs, peg->data + i*vs, vs*sizeof(int));
+	tmpSet = peg->newArcs[k];
+	peg->newArcs[k] = peg->newArcs[i];
+	peg->newArcs[i] = tmpSet;
+	peg->arcOffset[k] = peg->arcOffset[i];
       }
-      if (aIdx != curArc)
-	fprintf(errfile,"PE%3d: ERROR: aIdx (%d) != curArc (%d)\n",
-		MYNODE, aIdx, curArc);
-      for (j=0 ; j<newArc ; j++)
-	peg_SetArcHead(pegNew, vIdx, curArc+j, newArcsArr[idx0+j].head);
-
-      peg_SortArcs(pegNew, vIdx, ENTRV);
-      
-      vIdx++;
+      k++;
     }
+    else
+      peg_ArcSetClear(peg->newArcs + i);
   }
 
-  if (vIdx != pegNew->entrNum)
-    fprintf(errfile,"PE%3d: ERROR: vIdx (%d) != pegNew->entrNum (%d)\n",
-	    MYNODE, vIdx, pegNew->entrNum);
-  
-  
-  /* Exit Vertices */
-  vIdx   = 0;
-
+  /* Exit records */
+  k = 0;
   for (i=0 ; i<peg->exitNum ; i++) {
     if (peg->deadExitMask[i] == FALSE) {
-      peg_SetLabel  (pegNew, vIdx, EXITV, peg_GetLabel  (peg, i, EXITV));
-      peg_SetAdj    (pegNew, vIdx, EXITV, peg_GetAdj    (peg, i, EXITV));
-      peg_SetAdjAssn(pegNew, vIdx, EXITV, peg_GetAdjAssn(peg, i, EXITV));
-      peg_SetArcNum (pegNew, vIdx, EXITV, peg_GetArcNum (peg, i, EXITV));
-      vIdx++;
+      memmove(peg->data + (newEntr + k)*vs,
+	      peg->data + (peg->entrNum + i)*vs, vs*sizeof(int));
+      k++;
     }
   }
 
-  if (vIdx != pegNew->exitNum)
-    fprintf(errfile,"PE%3d: ERROR: vIdx (%d) != pegNew->exitNum (%d)\n",
-	    MYNODE, vIdx, pegNew->exitNum);
-  
-
-  free(newArcsArr);
+  /* Squeeze out the dead arcs; each live block only moves forward */
+  base = vs*(newEntr + newExit);
+  pos  = base;
+  pend = 0;
+  for (k=0 ; k<newEntr ; k++) {
+    off = peg->arcOffset[k];
+    num = peg_GetArcNum(peg, k, ENTRV);
+    peg->arcOffset[k] = pos;
+    live = 0;
+    for (j=0 ; j<num ; j++) {
+      if (peg->data[off + j] >= 0) {
+	peg->data[pos + live] = peg->data[off + j];
+	live++;
+      }
+    }
+    peg_SetArcNum(peg, k, ENTRV, live);
+    pos  += live;
+    pend += peg->newArcs[k].num;
+  }
+  newArcNum = (pos - base) + pend;
 
-  /* Swap in new data and parameters */
-  free(peg->data);
-  peg->entrNum  = pegNew->entrNum;
-  peg->exitNum  = pegNew->exitNum;
-  peg->arcNum   = pegNew->arcNum;
-  peg->data     = pegNew->data;
-#if 1
-  pegNew->data  = (int *)NULL;
+#ifdef DEBUG_PRINT
+  fprintf(outfile,"PE%3d: dead entr: %3d dead exit: %3d dead arc: %3d new arc: %3d\n",
+	  MYNODE, peg->entrNum - newEntr, peg->exitNum - newExit,
+	  peg->arcNum - (pos - base), pend);
 #endif
-  peg->newArcs  = pegNew->newArcs;
-  peg->deadEntr = pegNew->deadEntr;
-  peg->deadExit = pegNew->deadExit;
-  peg->deadArc  = pegNew->deadArc;
-  peg->newArc   = pegNew->newArc;
-  
-  peg->deadEntrMask = (BOOL *)SAFE_MALLOC(peg->entrNum * sizeof(BOOL),
-					  "(cycle.c) peg->deadEntrMask");
+
+  newInts = peg_GetDataInInts_Var(newEntr, newExit, newArcNum);
+  if (newInts > oldInts) {
+    peg->data = (int *)realloc(peg->data, newInts*sizeof(int));
+    if (peg->data == (int *)NULL)
+      fprintf(errfile,"PE%3d: ERROR: realloc failed in peg_CleanUp\n",
+	      MYNODE);
+  }
+
+  /* Open room for the new arcs, last entrance first */
+  pos = base + newArcNum;
+  for (k=newEntr-1 ; k>=0 ; k--) {
+    set  = peg->newArcs + k;
+    live = peg_GetArcNum(peg, k, ENTRV);
+    pos -= live + set->num;
+    if (pos != peg->arcOffset[k])
+      memmove(peg->data + pos, peg->data + peg->arcOffset[k],
+	      live*sizeof(int));
+    peg->arcOffset[k] = pos;
+    if (set->num > 0) {
+      num = live;
+      for (j=0 ; j<set->size ; j++)
+	if (set->slot[j] >= 0)
+	  peg->data[pos + num++] = set->slot[j];
+      if (num != live + set->num)
+	fprintf(errfile,"PE%3d: ERROR: aIdx (%d) != curArc+newArc (%d)\n",
+		MYNODE, num, live + set->num);
+      peg_SetArcNum(peg, k, ENTRV, live + set->num);
+      peg_SortArcs(peg, k, ENTRV);
+      peg_ArcSetClear(set);
+    }
+  }
+  if (pos != base)
+    fprintf(errfile,"PE%3d: ERROR: arc base (%d) != %d\n",
+	    MYNODE, pos, base);
+
+  peg->entrNum = newEntr;
+  peg->exitNum = newExit;
+  peg->arcNum  = newArcNum;
+  peg->arcOffset[newEntr] = base + newArcNum;
+
+  if (newInts < oldInts) {
+    peg->data = (int *)realloc(peg->data, (newInts > 0 ? newInts : 1)*sizeof(int));
+    if (peg->data == (int *)NULL)
+      fprintf(errfile,"PE%3d: ERROR: realloc failed in peg_CleanUp\n",
+	      MYNODE);
+  }
+
+  /* The masks only shrink, so clear the live prefix and reuse them */
+  peg->deadEntr = 0;
+  peg->deadExit = 0;
+  peg->deadArc  = 0;
+  peg->newArc   = 0;
   for (i=0 ; i<peg->entrNum ; i++)
     *(peg->deadEntrMask + i) = FALSE;
-
-  peg->deadExitMask = (BOOL *)SAFE_MALLOC(peg->exitNum * sizeof(BOOL),
-					  "(cycle.c) peg->deadExitMask");
   for (i=0 ; i<peg->exitNum ; i++)
     *(peg->deadExitMask + i) = FALSE;
-    
-  Free_ExpressPack(pegNew);
+
   return;
 }
 
-void ExpressMerge(pExpGraph_t *p0Ptr, pExpGraph_t p1, int h) {
-  /* Merge p1 into p0 */
-  pExpGraph_t pTemp;
-  pExpGraph_t p0;
-  int *ptr, *loc0, *loc1;
-  int siz;
-  int i, j, k;
-  int curAdjAssn, origAdjAssn;
-  int exit0, exit0Idx, entr1, entr1Idx, exit1;
-  int entr1ArcNum;
-  int p, s;
-
-  int entr0Num;
-  int *entr0List;
+BOOL peg_IsCompact(pExpGraph_t peg) {
+  /* No dead vertices, dead arcs or pending arcs */
+  return ((peg->deadEntr == 0) && (peg->deadExit == 0) &&
+	  (peg->deadArc  == 0) && (peg->newArc   == 0));
+}
 
-  int exit1Num;
-  int *exit1List;
-  int exit1Lab;
+BOOL peg_NeedCleanUp(pExpGraph_t peg) {
+  /* Compaction policy applied at the end of each merge */
+#if LAZY_CLEANUP
+  double dead;
 
-  p0 = *p0Ptr;
-  
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: MY P0  MERGE AT THE START OF THINGS\n",MYNODE);
-  Print_myExpressPack(p0);
-  fprintf(outfile,"PE%3d: MY P0  MERGE AT THE START OF THINGS DONE\n",MYNODE);
-  fflush(outfile);
+  dead = (double)peg_GetVSize()*(peg->deadEntr + peg->deadExit) +
+         (double)peg_GetASize()*peg->deadArc;
+  return ((dead > LAZY_CLEANUP_DEAD * (double)peg_GetDataInInts(peg)) ||
+	  ((double)peg->newArc > LAZY_CLEANUP_PEND * (double)peg->arcNum));
+#else
+  return (!peg_IsCompact(peg));
 #endif
+}
 
-  pTemp = (pExpGraph_t)SAFE_MALLOC(sizeof(struct pExpGraph_s),
-				   "(cycle.c) pTemp");
-  
-  pTemp->entrNum = p0->entrNum + p1->entrNum;
-  pTemp->exitNum = p0->exitNum + p1->exitNum;
-  pTemp->arcNum  = p0->arcNum  + p1->arcNum;
+/*************************************************************************/
+/* Dead-end pruning.  An entrance with no express arc to a live exit     */
+/* cannot lie on a cycle, and neither can an exit that no live entrance  */
+/* reaches.  Removing one can strand the other kind, so both are worked  */
+/* off a stack until nothing more falls out.                             */
+/*************************************************************************/
 
-  peg_Init(pTemp);
+void peg_RemoveOrphans(pExpGraph_t peg, int h) {
+  /* After stage h's eliminations, any live entrance whose paired exit
+     lies inside the merged group lost that exit to pruning */
+  int i;
 
-  ptr  = pTemp->data;
+  for (i=0 ; i<peg->entrNum ; i++)
+    if ((peg->deadEntrMask[i] == FALSE) &&
+	(clearLastB(peg_GetAdjAssn(peg, i, ENTRV), h) == MERGENODE))
+      peg_RemoveVertex(peg, i, ENTRV);
+  return;
+}
 
-  siz  = p0->entrNum*peg_GetVSize();
-  loc0 = p0->data;
-  memcpy(ptr, loc0, siz*sizeof(int));
-  ptr += siz;
+int peg_Prune(pExpGraph_t peg) {
+  /* Remove dead-end vertices, returning the number removed */
+  pegIndex_t ix;
+  pArcSet_t set;
+  BOOL built;
+  int *arcLive, *predLive, *stack;
+  int top, removed, i, k, x, slot, rec, arcnum, head;
+
+  if ((peg->entrNum == 0) && (peg->exitNum == 0))
+    return (0);
+
+  if (peg->arcOffset == (int *)NULL)
+    peg_SetArcOffsets(peg);
+  built = (peg->index == (pegIndex_t)NULL);
+  if (built)
+    peg_BuildIndex(peg);
+  ix = peg->index;
+
+  /* arcLive: arcs of each entrance to a label with a live exit.
+     predLive: arcs from live entrances to each label.
+     Stack entries are entrance i as i, exit x as -(x+1). */
+  arcLive  = (int *)SAFE_MALLOC(peg->entrNum*sizeof(int), "(cycle.c) arcLive");
+  predLive = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int), "(cycle.c) predLive");
+  stack    = (int *)SAFE_MALLOC((peg->entrNum + peg->exitNum)*sizeof(int),
+				"(cycle.c) stack");
+  for (i=0 ; i<ix->labelSize ; i++)
+    predLive[i] = 0;
+
+  top = 0;
+  for (i=0 ; i<peg->entrNum ; i++) {
+    arcLive[i] = 0;
+    if (peg->deadEntrMask[i] == TRUE)
+      continue;
+    arcnum = peg_GetArcNum(peg, i, ENTRV);
+    set    = peg->newArcs + i;
+    for (k=0 ; k<arcnum+set->size ; k++) {
+      head = (k < arcnum) ? peg_GetArcHead(peg, i, k) : set->slot[k-arcnum];
+      if (head < 0)
+	continue;
+      slot = peg_IndexLabelSlot(ix, head, FALSE);
+      predLive[slot]++;
+      if (ix->labelLive[slot] > 0)
+	arcLive[i]++;
+    }
+    if (arcLive[i] == 0)
+      stack[top++] = i;
+  }
+  for (x=0 ; x<peg->exitNum ; x++) {
+    if ((peg->deadExitMask[x] == FALSE) &&
+	(predLive[peg_IndexLabelSlot(ix, peg_GetLabel(peg, x, EXITV), FALSE)] == 0))
+      stack[top++] = -(x+1);
+  }
 
-  siz  = p1->entrNum*peg_GetVSize();
-  loc1 = p1->data;
-  memcpy(ptr, loc1, siz*sizeof(int));
-  ptr += siz;
+  removed = 0;
+  while (top > 0) {
+    top--;
+    if (stack[top] >= 0) {
+      i = stack[top];
+      if (peg->deadEntrMask[i] == TRUE)
+	continue;
+      arcnum = peg_GetArcNum(peg, i, ENTRV);
+      set    = peg->newArcs + i;
+      for (k=0 ; k<arcnum+set->size ; k++) {
+	head = (k < arcnum) ? peg_GetArcHead(peg, i, k) : set->slot[k-arcnum];
+	if (head < 0)
+	  continue;
+	slot = peg_IndexLabelSlot(ix, head, FALSE);
+	predLive[slot]--;
+	if ((predLive[slot] == 0) && (ix->labelLive[slot] > 0)) {
+	  for (x=ix->labelExit[slot] ; x>=0 ; x=ix->exitNext[x])
+	    if (peg->deadExitMask[x] == FALSE)
+	      stack[top++] = -(x+1);
+	}
+      }
+      peg_RemoveVertex(peg, i, ENTRV);
+      removed++;
+    }
+    else {
+      x = -stack[top] - 1;
+      if (peg->deadExitMask[x] == TRUE)
+	continue;
+      slot = peg_IndexLabelSlot(ix, peg_GetLabel(peg, x, EXITV), FALSE);
+      peg_RemoveVertex(peg, x, EXITV);
+      removed++;
+      if (ix->labelLive[slot] == 0) {
+	/* The label is gone, so arcs to it no longer lead anywhere */
+	for (rec=ix->labelPred[slot] ; rec>=0 ; rec=ix->predNext[rec]) {
+	  i = ix->predEntr[rec];
+	  if (peg->deadEntrMask[i] == FALSE) {
+	    arcLive[i]--;
+	    if (arcLive[i] == 0)
+	      stack[top++] = i;
+	  }
+	}
+      }
+    }
+  }
 
-  siz   = p0->exitNum*peg_GetVSize();
-  loc0 += p0->entrNum*peg_GetVSize();
-  memcpy(ptr, loc0 , siz*sizeof(int));
-  ptr += siz;
+  free(stack);
+  free(predLive);
+  free(arcLive);
+  if (built)
+    peg_FreeIndex(peg);
+  return (removed);
+}
 
-  siz   = p1->exitNum*peg_GetVSize();
-  loc1 += p1->entrNum*peg_GetVSize();
-  memcpy(ptr, loc1, siz*sizeof(int));
-  ptr += siz;
-  
-  siz   = p0->arcNum*peg_GetASize();
-  loc0 += p0->exitNum*peg_GetVSize();
-  memcpy(ptr, loc0 , siz*sizeof(int));
-  ptr += siz;
+/*************************************************************************/
+/* Dense merge backend: each entrance is a row of bits over the distinct */
+/* labels, split into the arcs it came with (base) and the arcs added    */
+/* during this merge (pend).  Eliminating exit0 ORs entr1's row into the */
+/* row of every entrance with an arc to exit0.                           */
+/*************************************************************************/
+
+typedef unsigned long denseWord_t;
+#define DENSE_WORDBITS (8*(int)sizeof(denseWord_t))
+
+int peg_DenseCol(int *colLabel, int colNum, int label) {
+  /* Binary search for label in the sorted column labels */
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = colNum - 1;
+  while (lo <= hi) {
+    mid = lo + (hi - lo) / 2;
+    if (colLabel[mid] < label)
+      lo = mid + 1;
+    else {
+      if (colLabel[mid] > label)
+	hi = mid - 1;
+      else
+	return (mid);
+    }
+  }
+  return (-1);
+}
 
-  siz   = p1->arcNum*peg_GetASize();
-  loc1 += p1->exitNum*peg_GetVSize();
-  memcpy(ptr, loc1, siz*sizeof(int));
-  ptr += siz;
+void peg_DenseOrRow(denseWord_t *pend, denseWord_t *base, denseWord_t *succ,
+		    int words) {
+  /* pend |= succ & ~base */
+  int w;
+
+  w = 0;
+#if defined(__AVX2__)
+  if (sizeof(denseWord_t) == 8) {
+    __m256i vs, vb, vp;
+    for ( ; w+4 <= words ; w += 4) {
+      vs = _mm256_loadu_si256((__m256i *)(succ + w));
+      vb = _mm256_loadu_si256((__m256i *)(base + w));
+      vp = _mm256_loadu_si256((__m256i *)(pend + w));
+      vp = _mm256_or_si256(vp, _mm256_andnot_si256(vb, vs));
+      _mm256_storeu_si256((__m256i *)(pend + w), vp);
+    }
+  }
+#endif
+  for ( ; w<words ; w++)
+    pend[w] |= succ[w] & ~base[w];
+  return;
+}
 
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: MY P0  MERGE\n",MYNODE);
-  Print_myExpressPack(p0);
-  fprintf(outfile,"PE%3d: MY P0  MERGE DONE\n",MYNODE);
-  fflush(outfile);
-  fprintf(outfile,"PE%3d: MY P1  MERGE\n",MYNODE);
-  Print_myExpressPack(p1);
-  fprintf(outfile,"PE%3d: MY P1  MERGE DONE\n",MYNODE);
-  fflush(outfile);
+int peg_DensePopCount(denseWord_t x) {
+#if defined(__GNUC__)
+  return (__builtin_popcountl(x));
+#else
+  int n;
+  n = 0;
+  while (x) {
+    x &= x - 1;
+    n++;
+  }
+  return (n);
+#endif
+}
 
-  fprintf(outfile,"PE%3d: MY P0+P1    MERGE\n",MYNODE);
-  Print_myExpressPack(pTemp);
-  fprintf(outfile,"PE%3d: MY P0+P1    MERGE DONE\n",MYNODE);
-  fflush(outfile);
+int peg_DenseLowBit(denseWord_t x) {
+#if defined(__GNUC__)
+  return (__builtin_ctzl(x));
+#else
+  int b;
+  b = 0;
+  while (!(x & 1)) {
+    x >>= 1;
+    b++;
+  }
+  return (b);
 #endif
+}
 
-  /****** MERGE HERE ********/
+/*************************************************************************/
+/* Team dense merge.  The leader works out the pivot sequence up front   */
+/* (exit0 column, entr1 row, and whether the column dies) since it does  */
+/* not depend on the rows, and deals the rows out in contiguous blocks.  */
+/* Each pivot then costs one broadcast of entr1's row from its owner.    */
+/*************************************************************************/
 
-  for (i=0 ; i<pTemp->exitNum ; i++) {
-    exit0Idx = i;
-    origAdjAssn = peg_GetAdjAssn(pTemp, exit0Idx, EXITV);
-    curAdjAssn  = clearLastB(origAdjAssn, h);
-#ifdef DEBUG_PRINT
-    fprintf(outfile,"PE%3d: h: %d orig: %d cur: %d\n",
-	    MYNODE, h, origAdjAssn, curAdjAssn);
-#endif
-    if (curAdjAssn == MYNODE) {
-      /* we have a winner */
+#define DENSE_TEAM_DONE (-1)
 
-      /* must locate the set of entrance vertices pointing to us,
-	 the entrance vertex we point to, and
-	 the set of exit vertices that it points to */
+void Dense_RowBlock(int rows, int t, int T, int *lo, int *num) {
+  /* Rows [lo, lo+num) of team member t */
+  *num = rows / T + ((t < rows % T) ? 1 : 0);
+  *lo  = t * (rows / T) + min(t, rows % T);
+  return;
+}
 
-      /* entr0 ------> exit0 ------> entr1 ------> exit1 */
-      /*         exit0Idx,EXITV     entr1Idx,ENTRV       */
-      
-      /* exit0Idx,EXITV = index of the exit vertex */
-      /* exit0 = label of the exit vertex */
-      exit0 = peg_GetLabel(pTemp, exit0Idx, EXITV);
+int Dense_RowOwner(int rows, int T, int j) {
+  int q, r;
+  q = rows / T;
+  r = rows % T;
+  if (j < r*(q+1))
+    return (j / (q+1));
+  return (r + (j - r*(q+1)) / q);
+}
 
-      /* entr1 = label of the entrance vertex we point to */
-      entr1     = peg_GetAdj    (pTemp, exit0Idx, EXITV);
+int Dense_TeamSweep(denseWord_t *base, denseWord_t *pend, int rowLo, int rowNum,
+		    int rows, int words, int *piv, int pivNum, denseWord_t *hasExit) {
+  /* Apply the pivots to this member's rows.  Returns the pivot at which
+     entr1 turned out to reach exit0 (a cycle), or -1 */
+  denseWord_t *row, *succ, *rb, *rp, m, any;
+  int k, j, w, wi, c0, entr1Idx, owner, me, found;
+
+  MPI_Comm_rank(mergeTeam, &me);
+  row  = (denseWord_t *)SAFE_MALLOC(words * sizeof(denseWord_t),
+				    "(cycle.c) row");
+  succ = (denseWord_t *)SAFE_MALLOC(words * sizeof(denseWord_t),
+				    "(cycle.c) succ");
+
+  found = -1;
+  for (k=0 ; k<pivNum ; k++) {
+    c0       = piv[4*k+1];
+    entr1Idx = piv[4*k+2];
+    wi = c0 / DENSE_WORDBITS;
+    m  = ((denseWord_t)1) << (c0 % DENSE_WORDBITS);
+
+    any = 0;
+    if (entr1Idx >= 0) {
+      owner = Dense_RowOwner(rows, mergeTeamSize, entr1Idx);
+      if (owner == me) {
+	rb = base + (entr1Idx - rowLo)*words;
+	rp = pend + (entr1Idx - rowLo)*words;
+	for (w=0 ; w<words ; w++)
+	  row[w] = rb[w] | rp[w];
+      }
+      MPI_Bcast(row, words*sizeof(denseWord_t), MPI_BYTE, owner, mergeTeam);
+      if (row[wi] & m) {
+	found = k;
+	break;
+      }
+      for (w=0 ; w<words ; w++) {
+	succ[w] = row[w] & hasExit[w];
+	any |= succ[w];
+      }
+    }
 
-      /* entr1Idx,ENTRV = index of the entrance vertex */
-      entr1Idx  = peg_GetEntrIdx(pTemp, entr1, exit0);
-#ifdef DEBUG_PRINT
-      fprintf(outfile,"PE%3d: h: %d orig: %d cur: %d exit0: %3d entr1: %3d entr1Idx: %3d\n",
-	    MYNODE, h, origAdjAssn, curAdjAssn, exit0, entr1, entr1Idx);
+    if (any) {
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static) if (rowNum*words >= OMP_MERGE_MINWORK)
 #endif
+      for (j=0 ; j<rowNum ; j++)
+	if ((base[j*words + wi] | pend[j*words + wi]) & m)
+	  peg_DenseOrRow(pend + j*words, base + j*words, succ, words);
+    }
 
-      /* If the express arc exists from entr1 to exit0, we have a cycle! */
+    if (piv[4*k+3])
+      for (j=0 ; j<rowNum ; j++)
+	base[j*words + wi] &= ~m;
+  }
 
-      if (peg_CheckArc(pTemp, entr1Idx, exit0)) {
-	fprintf(outfile,"PE%3d: HALT: CYCLE DETECTED DURING MERGE (%3d, %3d)\n",
-		MYNODE, exit0, entr1);
-	CYCLE_FOUND = TRUE;
-	return;
-      }
-      
-      /* Get list of the entrance vertices that have express arcs to exit0 */
+  free(succ);
+  free(row);
+  return (found);
+}
+
+void Dense_TeamRows(denseWord_t *base, denseWord_t *pend, int rows, int words,
+		    int *piv, int pivNum, denseWord_t *hasExit, int *found) {
+  /* Scatter the rows, sweep, and gather base|pend back into base.  On the
+     leader base and pend hold all rows, elsewhere they are NULL. */
+  int *cnt, *off;
+  int t, me, lo, num;
+  denseWord_t *myBase, *myPend;
+
+  MPI_Comm_rank(mergeTeam, &me);
+  cnt = (int *)SAFE_MALLOC(mergeTeamSize*sizeof(int), "(cycle.c) cnt");
+  off = (int *)SAFE_MALLOC(mergeTeamSize*sizeof(int), "(cycle.c) off");
+  for (t=0 ; t<mergeTeamSize ; t++) {
+    Dense_RowBlock(rows, t, mergeTeamSize, &lo, &num);
+    cnt[t] = num * words * sizeof(denseWord_t);
+    off[t] = lo  * words * sizeof(denseWord_t);
+  }
+  Dense_RowBlock(rows, me, mergeTeamSize, &lo, &num);
+
+  if (me == 0) {
+    myBase = base;
+    myPend = pend;
+    MPI_Scatterv(base, cnt, off, MPI_BYTE, MPI_IN_PLACE, cnt[0], MPI_BYTE,
+		 0, mergeTeam);
+    MPI_Scatterv(pend, cnt, off, MPI_BYTE, MPI_IN_PLACE, cnt[0], MPI_BYTE,
+		 0, mergeTeam);
+  }
+  else {
+    myBase = (denseWord_t *)SAFE_MALLOC(cnt[me] + 1, "(cycle.c) myBase");
+    myPend = (denseWord_t *)SAFE_MALLOC(cnt[me] + 1, "(cycle.c) myPend");
+    MPI_Scatterv(NULL, cnt, off, MPI_BYTE, myBase, cnt[me], MPI_BYTE,
+		 0, mergeTeam);
+    MPI_Scatterv(NULL, cnt, off, MPI_BYTE, myPend, cnt[me], MPI_BYTE,
+		 0, mergeTeam);
+  }
+
+  *found = Dense_TeamSweep(myBase, myPend, lo, num, rows, words,
+			   piv, pivNum, hasExit);
+
+  for (t=0 ; t<num*words ; t++)
+    myBase[t] |= myPend[t];
+  if (me == 0) {
+    MPI_Gatherv(MPI_IN_PLACE, cnt[0], MPI_BYTE, base, cnt, off, MPI_BYTE,
+		0, mergeTeam);
+    memset(pend, 0, rows * words * sizeof(denseWord_t));
+  }
+  else {
+    MPI_Gatherv(myBase, cnt[me], MPI_BYTE, NULL, cnt, off, MPI_BYTE,
+		0, mergeTeam);
+    free(myPend);
+    free(myBase);
+  }
+
+  free(off);
+  free(cnt);
+  return;
+}
+
+void Merge_TeamServe() {
+  /* Help the leader of mergeTeam with its dense merges until it is done */
+  int hdr[3], *piv, found;
+  denseWord_t *hasExit;
+
+  while (1) {
+    MPI_Bcast(hdr, 3, MPI_INT, 0, mergeTeam);
+    if (hdr[0] == DENSE_TEAM_DONE)
+      break;
+    hasExit = (denseWord_t *)SAFE_MALLOC(hdr[1] * sizeof(denseWord_t),
+					 "(cycle.c) hasExit");
+    piv = (int *)SAFE_MALLOC((4*hdr[2] + 1) * sizeof(int), "(cycle.c) piv");
+    MPI_Bcast(hasExit, hdr[1]*sizeof(denseWord_t), MPI_BYTE, 0, mergeTeam);
+    MPI_Bcast(piv, 4*hdr[2], MPI_INT, 0, mergeTeam);
+    Dense_TeamRows(NULL, NULL, hdr[0], hdr[1], piv, hdr[2], hasExit, &found);
+    free(piv);
+    free(hasExit);
+  }
+  return;
+}
+
+void Merge_TeamRelease() {
+  int hdr[3];
+
+  hdr[0] = DENSE_TEAM_DONE;
+  hdr[1] = 0;
+  hdr[2] = 0;
+  MPI_Bcast(hdr, 3, MPI_INT, 0, mergeTeam);
+  return;
+}
+
+void Dense_TeamMerge(pExpGraph_t peg, int h, int stageNum, int *exitCol, int *live,
+		     denseWord_t *base, denseWord_t *pend, denseWord_t *hasExit,
+		     int words) {
+  /* Leader side of ExpressMerge_Dense's eliminations with mergeTeam */
+  int *piv, pivNum, hdr[3], found;
+  int i, c0, origAdjAssn, exit0, entr1, entr1Idx;
+
+  /* Pivots in elimination order: exit0, its column, entr1's row and
+     whether exit0 was the last exit with its label */
+  piv = (int *)SAFE_MALLOC((4*stageNum + 1) * sizeof(int), "(cycle.c) piv");
+  pivNum = 0;
+  for (i=0 ; i<stageNum ; i++) {
+    origAdjAssn = peg_GetAdjAssn(peg, i, EXITV);
+    if ((clearLastB(origAdjAssn, h) == MERGENODE) &&
+	(peg->deadExitMask[i] == FALSE)) {
+      exit0    = peg_GetLabel(peg, i, EXITV);
+      entr1    = peg_GetAdj  (peg, i, EXITV);
+      entr1Idx = peg_FindEntrIdx(peg, entr1, exit0);
+      c0 = exitCol[i];
+      live[c0]--;
+      piv[4*pivNum]   = i;
+      piv[4*pivNum+1] = c0;
+      piv[4*pivNum+2] = entr1Idx;
+      piv[4*pivNum+3] = (live[c0] == 0);
+      pivNum++;
+      peg->deadExit++;
+      peg->deadExitMask[i] = TRUE;
+      if (entr1Idx >= 0) {
+	peg->deadEntr++;
+	peg->deadEntrMask[entr1Idx] = TRUE;
+      }
+    }
+  }
+
+  hdr[0] = peg->entrNum;
+  hdr[1] = words;
+  hdr[2] = pivNum;
+  MPI_Bcast(hdr, 3, MPI_INT, 0, mergeTeam);
+  MPI_Bcast(hasExit, words*sizeof(denseWord_t), MPI_BYTE, 0, mergeTeam);
+  MPI_Bcast(piv, 4*pivNum, MPI_INT, 0, mergeTeam);
+  Dense_TeamRows(base, pend, peg->entrNum, words, piv, pivNum, hasExit, &found);
+
+  if (found >= 0) {
+    i = piv[4*found];
+    fprintf(outfile,"PE%3d: HALT: CYCLE DETECTED DURING MERGE (%3d, %3d)\n",
+	    MYNODE, peg_GetLabel(peg, i, EXITV), peg_GetAdj(peg, i, EXITV));
+    CYCLE_FOUND = TRUE;
+  }
+  free(piv);
+  return;
+}
+
+BOOL ExpressMerge_Dense(pExpGraph_t peg, int h, int stageNum) {
+  /* Run the eliminations of ExpressMerge on the first stageNum exits of
+     peg using bitset rows, and compact peg.
+     Returns FALSE, leaving peg untouched, if peg is too sparse or too
+     large for the dense backend. */
+  int *colLabel, colNum, words;
+  int *exitCol, *live;
+  denseWord_t *base, *pend, *succ, *hasExit;
+  denseWord_t *rb, *rp, m, any, x;
+  pExpGraph_t pegNew;
+  pArcSet_t set;
+  struct pExpGraph_s tmp;
+  int i, j, k, w, c0, wi, arcnum, head, vIdx, aIdx, arcOff;
+  int origAdjAssn, exit0, entr1, entr1Idx;
+
+  if ((peg->entrNum == 0) || (peg->exitNum == 0))
+    return (FALSE);
+  if ((double)peg->arcNum <
+      DENSE_MERGE_DENSITY * (double)peg->entrNum * (double)peg->exitNum)
+    return (FALSE);
+
+  /* Columns are the distinct exit labels and arc heads, ascending, so
+     that a row read out in bit order is already sorted.  Vertices and
+     arcs carried over dead from an earlier stage are left out. */
+  colLabel = (int *)SAFE_MALLOC((peg->exitNum + peg->arcNum + peg->newArc) * sizeof(int),
+				"(cycle.c) colLabel");
+  colNum = 0;
+  for (i=0 ; i<peg->exitNum ; i++)
+    if (peg->deadExitMask[i] == FALSE)
+      colLabel[colNum++] = peg_GetLabel(peg, i, EXITV);
+  for (i=0 ; i<peg->entrNum ; i++) {
+    if (peg->deadEntrMask[i] == TRUE)
+      continue;
+    arcnum = peg_GetArcNum(peg, i, ENTRV);
+    for (k=0 ; k<arcnum ; k++) {
+      head = peg_GetArcHead(peg, i, k);
+      if (head >= 0)
+	colLabel[colNum++] = head;
+    }
+    set = peg->newArcs + i;
+    for (k=0 ; k<set->size ; k++)
+      if (set->slot[k] >= 0)
+	colLabel[colNum++] = set->slot[k];
+  }
+  qsort(colLabel, colNum, sizeof(int), intCompare);
+  j = 0;
+  for (i=0 ; i<colNum ; i++)
+    if ((j == 0) || (colLabel[i] != colLabel[j-1]))
+      colLabel[j++] = colLabel[i];
+  colNum = j;
+
+  words = (colNum + DENSE_WORDBITS - 1) / DENSE_WORDBITS;
+  if (2.0 * (double)peg->entrNum * (double)words * sizeof(denseWord_t) >
+      (double)DENSE_MERGE_MAXBYTES) {
+    free(colLabel);
+    return (FALSE);
+  }
+
+#ifdef DEBUG_PRINT
+  fprintf(outfile,"PE%3d: dense merge entr: %d cols: %d words: %d\n",
+	  MYNODE, peg->entrNum, colNum, words);
+#endif
+
+  base    = (denseWord_t *)SAFE_MALLOC(peg->entrNum * words * sizeof(denseWord_t),
+				       "(cycle.c) base");
+  pend    = (denseWord_t *)SAFE_MALLOC(peg->entrNum * words * sizeof(denseWord_t),
+				       "(cycle.c) pend");
+  succ    = (denseWord_t *)SAFE_MALLOC(words * sizeof(denseWord_t),
+				       "(cycle.c) succ");
+  hasExit = (denseWord_t *)SAFE_MALLOC(words * sizeof(denseWord_t),
+				       "(cycle.c) hasExit");
+  live    = (int *)SAFE_MALLOC(colNum * sizeof(int), "(cycle.c) live");
+  exitCol = (int *)SAFE_MALLOC(peg->exitNum * sizeof(int), "(cycle.c) exitCol");
+
+  memset(base,    0, peg->entrNum * words * sizeof(denseWord_t));
+  memset(pend,    0, peg->entrNum * words * sizeof(denseWord_t));
+  memset(hasExit, 0, words * sizeof(denseWord_t));
+  for (i=0 ; i<colNum ; i++)
+    live[i] = 0;
+
+  for (i=0 ; i<peg->exitNum ; i++) {
+    if (peg->deadExitMask[i] == TRUE) {
+      exitCol[i] = -1;
+      continue;
+    }
+    c0 = peg_DenseCol(colLabel, colNum, peg_GetLabel(peg, i, EXITV));
+    exitCol[i] = c0;
+    live[c0]++;
+    hasExit[c0 / DENSE_WORDBITS] |= ((denseWord_t)1) << (c0 % DENSE_WORDBITS);
+  }
+
+  for (i=0 ; i<peg->entrNum ; i++) {
+    if (peg->deadEntrMask[i] == TRUE)
+      continue;
+    rb = base + i*words;
+    arcnum = peg_GetArcNum(peg, i, ENTRV);
+    for (k=0 ; k<arcnum ; k++) {
+      head = peg_GetArcHead(peg, i, k);
+      if (head >= 0) {
+	c0 = peg_DenseCol(colLabel, colNum, head);
+	rb[c0 / DENSE_WORDBITS] |= ((denseWord_t)1) << (c0 % DENSE_WORDBITS);
+      }
+    }
+    rp  = pend + i*words;
+    set = peg->newArcs + i;
+    for (k=0 ; k<set->size ; k++) {
+      if (set->slot[k] >= 0) {
+	c0 = peg_DenseCol(colLabel, colNum, set->slot[k]);
+	rp[c0 / DENSE_WORDBITS] |= ((denseWord_t)1) << (c0 % DENSE_WORDBITS);
+      }
+    }
+  }
+
+  /****** MERGE HERE ********/
+
+  /* A team merge eliminates the whole stage and marks it dead, which
+     leaves nothing for the loop below */
+  if (mergeTeamSize > 1)
+    Dense_TeamMerge(peg, h, stageNum, exitCol, live, base, pend, hasExit, words);
+
+  for (i=0 ; i<stageNum ; i++) {
+    origAdjAssn = peg_GetAdjAssn(peg, i, EXITV);
+    if ((clearLastB(origAdjAssn, h) == MERGENODE) &&
+	(peg->deadExitMask[i] == FALSE)) {
+      /* entr0 ------> exit0 ------> entr1 ------> exit1 */
+      exit0    = peg_GetLabel(peg, i, EXITV);
+      entr1    = peg_GetAdj  (peg, i, EXITV);
+      entr1Idx = peg_FindEntrIdx(peg, entr1, exit0);
+
+      c0 = exitCol[i];
+      wi = c0 / DENSE_WORDBITS;
+      m  = ((denseWord_t)1) << (c0 % DENSE_WORDBITS);
+
+      /* entr1 may have been pruned as a dead end */
+      any = 0;
+      if (entr1Idx >= 0) {
+	rb = base + entr1Idx*words;
+	rp = pend + entr1Idx*words;
+
+	/* If the express arc exists from entr1 to exit0, we have a cycle! */
+	if ((rb[wi] | rp[wi]) & m) {
+	  fprintf(outfile,"PE%3d: HALT: CYCLE DETECTED DURING MERGE (%3d, %3d)\n",
+		  MYNODE, exit0, entr1);
+	  CYCLE_FOUND = TRUE;
+	  break;
+	}
+
+	/* Express arcs of entr1 that lead to an exit */
+	for (w=0 ; w<words ; w++) {
+	  succ[w] = (rb[w] | rp[w]) & hasExit[w];
+	  any |= succ[w];
+	}
+      }
+
+      if (any) {
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static) if (peg->entrNum*words >= OMP_MERGE_MINWORK)
+#endif
+	for (j=0 ; j<peg->entrNum ; j++) {
+	  if ((peg->deadEntrMask[j] == FALSE) &&
+	      ((base[j*words + wi] | pend[j*words + wi]) & m))
+	    peg_DenseOrRow(pend + j*words, base + j*words, succ, words);
+	}
+      }
+
+      /* Remove exit0; if it was the last exit with its label, the
+	 original arcs aimed at the label go with it */
+      peg->deadExit++;
+      peg->deadExitMask[i] = TRUE;
+      live[c0]--;
+      if (live[c0] == 0) {
+	for (j=0 ; j<peg->entrNum ; j++)
+	  if (peg->deadEntrMask[j] == FALSE)
+	    base[j*words + wi] &= ~m;
+      }
+
+      /* Remove entr1 */
+      if (entr1Idx >= 0) {
+	peg->deadEntr++;
+	peg->deadEntrMask[entr1Idx] = TRUE;
+      }
+    }
+  }
+
+#if PRUNE_DEADENDS
+  /* Entrances whose paired exit was pruned */
+  for (j=0 ; j<peg->entrNum ; j++) {
+    if ((peg->deadEntrMask[j] == FALSE) &&
+	(clearLastB(peg_GetAdjAssn(peg, j, ENTRV), h) == MERGENODE)) {
+      peg->deadEntr++;
+      peg->deadEntrMask[j] = TRUE;
+    }
+  }
+#endif
+
+  if (!CYCLE_FOUND) {
+    pegNew = (pExpGraph_t)SAFE_MALLOC(sizeof(struct pExpGraph_s),
+				      "(cycle.c) pegNew");
+    pegNew->entrNum = peg->entrNum - peg->deadEntr;
+    pegNew->exitNum = peg->exitNum - peg->deadExit;
+    pegNew->arcNum  = 0;
+    for (i=0 ; i<peg->entrNum ; i++)
+      if (peg->deadEntrMask[i] == FALSE)
+	for (w=0 ; w<words ; w++)
+	  pegNew->arcNum += peg_DensePopCount(base[i*words+w] | pend[i*words+w]);
+
+    peg_Init(pegNew);
+    pegNew->arcOffset = (int *)SAFE_MALLOC((pegNew->entrNum+1)*sizeof(int),
+					   "(cycle.c) pegNew->arcOffset");
+    arcOff = peg_GetVSize()*(pegNew->entrNum + pegNew->exitNum);
+
+    vIdx = 0;
+    for (i=0 ; i<peg->entrNum ; i++) {
+      if (peg->deadEntrMask[i] == FALSE) {
+	peg_SetLabel  (pegNew, vIdx, ENTRV, peg_GetLabel  (peg, i, ENTRV));
+	peg_SetAdj    (pegNew, vIdx, ENTRV, peg_GetAdj    (peg, i, ENTRV));
+	peg_SetAdjAssn(pegNew, vIdx, ENTRV, peg_GetAdjAssn(peg, i, ENTRV));
+	arcnum = 0;
+	for (w=0 ; w<words ; w++)
+	  arcnum += peg_DensePopCount(base[i*words+w] | pend[i*words+w]);
+	peg_SetArcNum(pegNew, vIdx, ENTRV, arcnum);
+	pegNew->arcOffset[vIdx] = arcOff;
+	arcOff += peg_GetASize()*arcnum;
+	aIdx = 0;
+	for (w=0 ; w<words ; w++) {
+	  x = base[i*words+w] | pend[i*words+w];
+	  while (x) {
+	    peg_SetArcHead(pegNew, vIdx, aIdx,
+			   colLabel[w*DENSE_WORDBITS + peg_DenseLowBit(x)]);
+	    aIdx++;
+	    x &= x - 1;
+	  }
+	}
+	vIdx++;
+      }
+    }
+    pegNew->arcOffset[pegNew->entrNum] = arcOff;
+
+    vIdx = 0;
+    for (i=0 ; i<peg->exitNum ; i++) {
+      if (peg->deadExitMask[i] == FALSE) {
+	peg_SetLabel  (pegNew, vIdx, EXITV, peg_GetLabel  (peg, i, EXITV));
+	peg_SetAdj    (pegNew, vIdx, EXITV, peg_GetAdj    (peg, i, EXITV));
+	peg_SetAdjAssn(pegNew, vIdx, EXITV, peg_GetAdjAssn(peg, i, EXITV));
+	peg_SetArcNum (pegNew, vIdx, EXITV, peg_GetArcNum (peg, i, EXITV));
+	vIdx++;
+      }
+    }
+
+    /* Swap the compacted graph into peg and free the old one */
+    peg_FreeIndex(peg);
+    tmp     = *peg;
+    *peg    = *pegNew;
+    *pegNew = tmp;
+    Free_ExpressPack(pegNew);
+  }
+
+  free(exitCol);
+  free(live);
+  free(hasExit);
+  free(succ);
+  free(pend);
+  free(base);
+  free(colLabel);
+
+  return (TRUE);
+}
+
+/*************************************************************************/
+/* Elimination order.  Removing exit0 and its entr1 adds up to           */
+/* preds(exit0) x succs(entr1) express arcs, so the stage's exits are    */
+/* popped from a heap on that product.  Keys are refreshed lazily: a     */
+/* popped exit whose product has grown since it was keyed is pushed back */
+/*************************************************************************/
+
+double peg_ElimFill(pExpGraph_t peg, int exitIdx) {
+  /* preds(exit0) x succs(entr1), read from the merge index */
+  pegIndex_t ix;
+  int slot, rec, preds, succs, entr1Idx;
+
+  ix = peg->index;
+  preds = 0;
+  slot = peg_IndexLabelSlot(ix, peg_GetLabel(peg, exitIdx, EXITV), FALSE);
+  rec  = (slot >= 0) ? ix->labelPred[slot] : -1;
+  while (rec >= 0) {
+    if (peg->deadEntrMask[ix->predEntr[rec]] == FALSE)
+      preds++;
+    rec = ix->predNext[rec];
+  }
+
+  entr1Idx = peg_FindEntrIdx(peg, peg_GetAdj(peg, exitIdx, EXITV),
+			     peg_GetLabel(peg, exitIdx, EXITV));
+  succs = (entr1Idx < 0) ? 0 :
+    peg_GetArcNum(peg, entr1Idx, ENTRV) + peg->newArcs[entr1Idx].num;
+
+  return ((double)preds * (double)succs);
+}
+
+void peg_ElimHeapDown(elimOrder_t ord, int k) {
+  int c, t;
+  double tk;
+
+  while ((c = 2*k + 1) < ord->num) {
+    if ((c + 1 < ord->num) && (ord->key[c+1] < ord->key[c]))
+      c++;
+    if (ord->key[k] <= ord->key[c])
+      break;
+    tk = ord->key[k];     ord->key[k]     = ord->key[c];     ord->key[c]     = tk;
+    t  = ord->exitIdx[k]; ord->exitIdx[k] = ord->exitIdx[c]; ord->exitIdx[c] = t;
+    k = c;
+  }
+  return;
+}
+
+elimOrder_t peg_ElimOrderInit(pExpGraph_t peg, int stageNum) {
+  /* Heap over the first stageNum (this stage's) exits */
+  elimOrder_t ord;
+#if ELIM_ORDER
+  int i;
+#endif
+
+  ord = (elimOrder_t)SAFE_MALLOC(sizeof(struct elimOrder_s),
+				 "(cycle.c) ord");
+  ord->next = 0;
+  ord->num  = 0;
+  ord->key     = (double *)NULL;
+  ord->exitIdx = (int *)NULL;
+#if ELIM_ORDER
+  ord->key     = (double *)SAFE_MALLOC(stageNum*sizeof(double),
+				       "(cycle.c) ord->key");
+  ord->exitIdx = (int *)SAFE_MALLOC(stageNum*sizeof(int),
+				    "(cycle.c) ord->exitIdx");
+  for (i=0 ; i<stageNum ; i++) {
+    if (peg->deadExitMask[i] == FALSE) {
+      ord->key[ord->num]     = peg_ElimFill(peg, i);
+      ord->exitIdx[ord->num] = i;
+      ord->num++;
+    }
+  }
+  for (i=ord->num/2 - 1 ; i>=0 ; i--)
+    peg_ElimHeapDown(ord, i);
+#else
+  ord->num = stageNum;
+#endif
+  return (ord);
+}
+
+int peg_ElimOrderNext(pExpGraph_t peg, elimOrder_t ord) {
+  /* Next exit to eliminate, or -1 when the stage is done */
+#if ELIM_ORDER
+  int idx;
+  double fill;
+
+  while (ord->num > 0) {
+    idx  = ord->exitIdx[0];
+    fill = peg_ElimFill(peg, idx);
+    if ((fill > ord->key[0]) && (ord->num > 1)) {
+      ord->key[0] = fill;
+      peg_ElimHeapDown(ord, 0);
+      if (ord->exitIdx[0] != idx)
+	continue;
+    }
+    ord->num--;
+    ord->key[0]     = ord->key[ord->num];
+    ord->exitIdx[0] = ord->exitIdx[ord->num];
+    peg_ElimHeapDown(ord, 0);
+    return (idx);
+  }
+  return (-1);
+#else
+  if (ord->next < ord->num)
+    return (ord->next++);
+  return (-1);
+#endif
+}
+
+void peg_ElimOrderFree(elimOrder_t ord) {
+  if (ord->key != (double *)NULL)
+    free(ord->key);
+  if (ord->exitIdx != (int *)NULL)
+    free(ord->exitIdx);
+  free(ord);
+  return;
+}
+
+void peg_TakeState(pExpGraph_t pTemp, pExpGraph_t p0) {
+  /* p0 may carry tombstones and pending arcs from an earlier stage;
+     they keep their indices at the front of pTemp, which holds p0's
+     vertices first */
+  int i;
+
+  for (i=0 ; i<p0->entrNum ; i++) {
+    pTemp->deadEntrMask[i] = p0->deadEntrMask[i];
+    pTemp->newArcs[i] = p0->newArcs[i];
+    p0->newArcs[i].num  = 0;
+    p0->newArcs[i].size = 0;
+    p0->newArcs[i].slot = (int *)NULL;
+  }
+  pTemp->deadEntr = p0->deadEntr;
+  pTemp->deadExit = p0->deadExit;
+  pTemp->deadArc  = p0->deadArc;
+  pTemp->newArc   = p0->newArc;
+  return;
+}
+
+void ExpressMerge_Stage(pExpGraph_t *p0Ptr, pExpGraph_t pTemp, int h,
+			int stageNum) {
+  /* Eliminate the stage-h exits of pTemp, which holds p0 and the packs
+     merged into it with its stageNum stage-h exits leading, and make it
+     the new p0 */
+  pExpGraph_t p0;
+  int j, k;
+  int curAdjAssn, origAdjAssn;
+  int exit0, exit0Idx, entr1, entr1Idx, exit1;
+  int entr1ArcNum;
+  pArcSet_t entr1Set;
+  int p, s;
+  elimOrder_t order;
+  int fill, pruned, elim;
+
+  int entr0Num;
+  int *entr0List;
+
+  int exit1Num;
+  int *exit1List;
+  int exit1Lab;
+
+  p0 = *p0Ptr;
+
+  if (pTemp->index == (pegIndex_t)NULL) {
+    peg_SetArcOffsets(pTemp);
+    peg_BuildIndex(pTemp);
+  }
+
+#ifdef DEBUG_PRINT
+  fprintf(outfile,"PE%3d: MY P0+P1    MERGE\n",MYNODE);
+  Print_myExpressPack(pTemp);
+  fprintf(outfile,"PE%3d: MY P0+P1    MERGE DONE\n",MYNODE);
+  fflush(outfile);
+#endif
+
+#if DENSE_MERGE
+  if (ExpressMerge_Dense(pTemp, h, stageNum)) {
+    if (CYCLE_FOUND)
+      return;
+#if PRUNE_DEADENDS
+    if ((peg_Prune(pTemp) > 0) && peg_NeedCleanUp(pTemp))
+      peg_CleanUp(pTemp);
+#endif
+#ifdef DEBUG_PRINT
+    Print_myExpressPack(pTemp);
+#endif
+    *p0Ptr = pTemp;
+    Free_ExpressPack(p0);
+    return;
+  }
+#endif
+
+  /****** MERGE HERE ********/
+
+  order = peg_ElimOrderInit(pTemp, stageNum);
+  fill  = 0;
+  elim  = 0;
+
+  while ((exit0Idx = peg_ElimOrderNext(pTemp, order)) >= 0) {
+    origAdjAssn = peg_GetAdjAssn(pTemp, exit0Idx, EXITV);
+    curAdjAssn  = clearLastB(origAdjAssn, h);
+#ifdef DEBUG_PRINT
+    fprintf(outfile,"PE%3d: h: %d orig: %d cur: %d\n",
+	    MYNODE, h, origAdjAssn, curAdjAssn);
+#endif
+    if ((curAdjAssn == MERGENODE) && (pTemp->deadExitMask[exit0Idx] == FALSE)) {
+      /* we have a winner */
+      elim++;
+
+      /* must locate the set of entrance vertices pointing to us,
+	 the entrance vertex we point to, and
+	 the set of exit vertices that it points to */
+
+      /* entr0 ------> exit0 ------> entr1 ------> exit1 */
+      /*         exit0Idx,EXITV     entr1Idx,ENTRV       */
+      
+      /* exit0Idx,EXITV = index of the exit vertex */
+      /* exit0 = label of the exit vertex */
+      exit0 = peg_GetLabel(pTemp, exit0Idx, EXITV);
+
+      /* entr1 = label of the entrance vertex we point to */
+      entr1     = peg_GetAdj    (pTemp, exit0Idx, EXITV);
+
+      /* entr1Idx,ENTRV = index of the entrance vertex, or -1 if it was
+	 pruned as a dead end, in which case exit0 leads nowhere */
+      entr1Idx  = peg_FindEntrIdx(pTemp, entr1, exit0);
+#ifdef DEBUG_PRINT
+      fprintf(outfile,"PE%3d: h: %d orig: %d cur: %d exit0: %3d entr1: %3d entr1Idx: %3d\n",
+	    MYNODE, h, origAdjAssn, curAdjAssn, exit0, entr1, entr1Idx);
+#endif
+
+      /* If the express arc exists from entr1 to exit0, we have a cycle! */
+
+      if ((entr1Idx >= 0) && peg_CheckArc(pTemp, entr1Idx, exit0)) {
+	fprintf(outfile,"PE%3d: HALT: CYCLE DETECTED DURING MERGE (%3d, %3d)\n",
+		MYNODE, exit0, entr1);
+	CYCLE_FOUND = TRUE;
+	return;
+      }
+      
+      /* Get list of the entrance vertices that have express arcs to exit0 */
       peg_GetEntrPred(pTemp, exit0, &entr0Num, &entr0List);
 
-      if (entr0Num > 0) {
+      if ((entr0Num > 0) && (entr1Idx >= 0)) {
 	/* For each express arc of entr1, replace it with the new express from
 	   entr0List to exit1 */
 	entr1ArcNum = peg_GetArcNum(pTemp, entr1Idx, ENTRV);
-	if (entr1ArcNum > 0) {
+	entr1Set    = pTemp->newArcs + entr1Idx;
+	if (entr1ArcNum + entr1Set->num > 0) {
 #ifdef DEBUG_PRINT
 	  fprintf(outfile,"PE%3d: entr1Idx: %2d [%2d : %2d] entr1ArcNum: %2d\n",
 		  MYNODE, entr1Idx, peg_GetLabel(pTemp, entr1Idx, ENTRV),
 		  entr1, entr1ArcNum);
 #endif
       
-	  exit1List = (int *)SAFE_MALLOC(pTemp->exitNum * sizeof(int),
+	  exit1List = (int *)SAFE_MALLOC((entr1ArcNum + entr1Set->num) * sizeof(int),
 					 "(cycle.c) exit1List");
 	  exit1Num = 0;
       
@@ -2035,182 +4031,1401 @@ void ExpressMerge(pExpGraph_t *p0Ptr, pExpGraph_t p1, int h) {
 	    exit1 = peg_GetArcHead(pTemp, entr1Idx, k);
 	    if (exit1 >= 0) {
 	      /* Add Express Arc from entr0 to exit1 */
-	      /* There could be multiple exit1's with the same label */
-	      for (j=0 ; j<pTemp->exitNum ; j++) {
-		if (peg_GetLabel(pTemp, j, EXITV) == exit1) {
-		  exit1List[exit1Num] = j;
-		  exit1Num++;
-		}
+	      /* There could be multiple exit1's with the same label, but
+		 they all give the same express arc, so keep just one */
+	      j = peg_IndexFirstExit(pTemp, exit1);
+	      if (j >= 0) {
+		exit1List[exit1Num] = j;
+		exit1Num++;
+	      }
+	    }
+	  }
+	  /* Arcs entr1 picked up earlier in this merge lead on as well */
+	  for (k=0 ; k<entr1Set->size ; k++) {
+	    exit1 = entr1Set->slot[k];
+	    if (exit1 >= 0) {
+	      j = peg_IndexFirstExit(pTemp, exit1);
+	      if (j >= 0) {
+		exit1List[exit1Num] = j;
+		exit1Num++;
 	      }
 	    }
 	  }
 
-	  if (exit1Num > pTemp->exitNum) {
-	    fprintf(errfile,"PE%3d: ERROR: exit1Num (%d) > pTemp->exitNum (%d)\n",
-		    MYNODE, exit1Num, pTemp->exitNum);
+	  if (exit1Num > entr1ArcNum + entr1Set->num) {
+	    fprintf(errfile,"PE%3d: ERROR: exit1Num (%d) > entr1ArcNum (%d)\n",
+		    MYNODE, exit1Num, entr1ArcNum + entr1Set->num);
 
 	  }
 
-	  if (exit1Num > 0) {
-	    /* We have entr0 and exit1 vertices to link */
-#ifdef DEBUG_PRINT
-	    for (k=0 ; k < entr0Num ; k++) {
-	      fprintf(outfile,
-		      "PE%3d: \t (%2d) exit0: %3d n:%3d  entr0Idx: %3d  label: %3d\n",
-		      MYNODE, k, exit0, entr0Num, entr0List[k],
-		      peg_GetLabel(pTemp, entr0List[k], ENTRV));
-	      fflush(outfile);
-	    }
-	    for (k=0 ; k < exit1Num ; k++) {
-	      fprintf(outfile,
-		      "PE%3d: \t (%2d) exit0: %3d n:%3d  exit1Idx: %3d  label: %3d\n",
-		      MYNODE, k, exit0, exit1Num, exit1List[k],
-		      peg_GetLabel(pTemp, exit1List[k], EXITV));
-	      fflush(outfile);
-	    }
+	  if (exit1Num > 0) {
+	    /* We have entr0 and exit1 vertices to link */
+#ifdef DEBUG_PRINT
+	    for (k=0 ; k < entr0Num ; k++) {
+	      fprintf(outfile,
+		      "PE%3d: \t (%2d) exit0: %3d n:%3d  entr0Idx: %3d  label: %3d\n",
+		      MYNODE, k, exit0, entr0Num, entr0List[k],
+		      peg_GetLabel(pTemp, entr0List[k], ENTRV));
+	      fflush(outfile);
+	    }
+	    for (k=0 ; k < exit1Num ; k++) {
+	      fprintf(outfile,
+		      "PE%3d: \t (%2d) exit0: %3d n:%3d  exit1Idx: %3d  label: %3d\n",
+		      MYNODE, k, exit0, exit1Num, exit1List[k],
+		      peg_GetLabel(pTemp, exit1List[k], EXITV));
+	      fflush(outfile);
+	    }
+#endif
+
+#ifdef USE_OPENMP
+	    if ((long)entr0Num*exit1Num >= OMP_MERGE_MINWORK)
+	      fill += peg_AddArcsOmp(pTemp, entr0List, entr0Num, exit1List, exit1Num);
+	    else
+#endif
+	    for (p=0 ; p<entr0Num ; p++) {
+	      for (s=0 ; s<exit1Num ; s++) {
+#ifdef DEBUG_PRINT
+		fprintf(outfile,"PE%3d: Testing express arc (%3d, %3d) idx %3d -> %3d\n",
+			MYNODE,
+			peg_GetLabel(pTemp, entr0List[p], ENTRV),
+			peg_GetLabel(pTemp, exit1List[s], EXITV),
+			entr0List[p], exit1List[s]);
+		fflush(outfile);
+#endif
+		/* If the arc doesn't exit, add it */
+		exit1Lab = peg_GetLabel(pTemp, exit1List[s], EXITV);
+		if (!peg_CheckArc(pTemp, entr0List[p], exit1Lab)) {
+#ifdef DEBUG_PRINT
+		  fprintf(outfile,"PE%3d: Adding  express arc (%3d, %3d) idx %3d -> %3d\n",
+			MYNODE,
+			peg_GetLabel(pTemp, entr0List[p], ENTRV),
+			peg_GetLabel(pTemp, exit1List[s], EXITV),
+			entr0List[p], exit1List[s]);
+		  fflush(outfile);
+#endif
+		  peg_AddArc(pTemp, entr0List[p], exit1Lab);
+		  fill++;
+		}
+#ifdef DEBUG_PRINT
+		else {
+		  fprintf(outfile,"PE%3d: Tossing express arc (%3d, %3d) idx %3d -> %3d\n",
+			MYNODE,
+			peg_GetLabel(pTemp, entr0List[p], ENTRV),
+			peg_GetLabel(pTemp, exit1List[s], EXITV),
+			entr0List[p], exit1List[s]);
+		  fflush(outfile);
+		}
+#endif
+		
+	      } /* foreach exit1 */
+	    } /* foreach entr0 */
+
+	  } /* (exit1Num > 0) */
+	  
+	  free(exit1List);
+	  
+	} /* (entr1ArcNum > 0) */
+	
+      } /* (entr0Num > 0) */
+      
+      free(entr0List);
+      
+      peg_RemoveVertex(pTemp, exit0Idx, EXITV);
+      if (entr1Idx >= 0)
+	peg_RemoveVertex(pTemp, entr1Idx, ENTRV);
+	    
+    } /* (curAdjAssn  == MERGENODE) */
+    
+  } /* foreach exit0 */
+
+  peg_ElimOrderFree(order);
+
+  pruned = 0;
+#if PRUNE_DEADENDS
+  peg_RemoveOrphans(pTemp, h);
+  pruned = peg_Prune(pTemp);
+#endif
+  if (PRINT_MERGESIZE)
+    fprintf(outfile,"PE%3d: [%3d] eliminated: %12d fill: %12d pruned: %12d\n",
+	    MYNODE, h, elim, fill, pruned);
+
+  peg_FreeIndex(pTemp);
+  if (peg_NeedCleanUp(pTemp))
+    peg_CleanUp(pTemp);
+
+#ifdef DEBUG_PRINT
+  Print_myExpressPack(pTemp);
+#endif
+  
+  *p0Ptr = pTemp;
+
+  Free_ExpressPack(p0);
+  return;
+}
+
+void ExpressMerge(pExpGraph_t *p0Ptr, pExpGraph_t p1, int h) {
+  /* Merge p1 into p0 */
+  pExpGraph_t pTemp;
+  pExpGraph_t p0;
+  int *ptr, *loc0, *loc1;
+  int siz;
+  int stageNum;
+
+  p0 = *p0Ptr;
+  
+#ifdef DEBUG_PRINT
+  fprintf(outfile,"PE%3d: MY P0  MERGE AT THE START OF THINGS\n",MYNODE);
+  Print_myExpressPack(p0);
+  fprintf(outfile,"PE%3d: MY P0  MERGE AT THE START OF THINGS DONE\n",MYNODE);
+  fflush(outfile);
+#endif
+
+  pTemp = (pExpGraph_t)SAFE_MALLOC(sizeof(struct pExpGraph_s),
+				   "(cycle.c) pTemp");
+  
+  pTemp->entrNum = p0->entrNum + p1->entrNum;
+  pTemp->exitNum = p0->exitNum + p1->exitNum;
+  pTemp->arcNum  = p0->arcNum  + p1->arcNum;
+
+  peg_Init(pTemp);
+
+  ptr  = pTemp->data;
+
+  siz  = p0->entrNum*peg_GetVSize();
+  loc0 = p0->data;
+  memcpy(ptr, loc0, siz*sizeof(int));
+  ptr += siz;
+
+  siz  = p1->entrNum*peg_GetVSize();
+  loc1 = p1->data;
+  memcpy(ptr, loc1, siz*sizeof(int));
+  ptr += siz;
+
+  /* Exits of this stage come first */
+  stageNum = peg_MergeExits(pTemp, p0, p1, h);
+  ptr  += (p0->exitNum + p1->exitNum)*peg_GetVSize();
+  loc0 += p0->entrNum*peg_GetVSize();
+  loc1 += p1->entrNum*peg_GetVSize();
+  
+  siz   = p0->arcNum*peg_GetASize();
+  loc0 += p0->exitNum*peg_GetVSize();
+  memcpy(ptr, loc0 , siz*sizeof(int));
+  ptr += siz;
+
+  siz   = p1->arcNum*peg_GetASize();
+  loc1 += p1->exitNum*peg_GetVSize();
+  memcpy(ptr, loc1, siz*sizeof(int));
+  ptr += siz;
+
+  peg_TakeState(pTemp, p0);
+
+#ifdef DEBUG_PRINT
+  fprintf(outfile,"PE%3d: MY P0  MERGE\n",MYNODE);
+  Print_myExpressPack(p0);
+  fprintf(outfile,"PE%3d: MY P0  MERGE DONE\n",MYNODE);
+  fflush(outfile);
+  fprintf(outfile,"PE%3d: MY P1  MERGE\n",MYNODE);
+  Print_myExpressPack(p1);
+  fprintf(outfile,"PE%3d: MY P1  MERGE DONE\n",MYNODE);
+  fflush(outfile);
+#endif
+
+  ExpressMerge_Stage(p0Ptr, pTemp, h, stageNum);
+  return;
+}
+
+#if PACK_ONEMSG && MERGE_INPLACE
+pExpGraph_t Recv_ExpressMergePacks(pExpGraph_t p0, int *fromList, int num,
+				   int h, int *stageNum) {
+  /* Receive the packs of the num ranks in fromList into p0's data, grown
+     to the merged size, and lay the lot out the way ExpressMerge would:
+     p0's entrances, then the others', the exits merged by stage, then
+     p0's arcs and the others' in order.  Whole packs land behind p0's
+     data; their arc blocks only ever move up, so they are shifted in
+     place, last first, once the vertex records are copied aside.  With
+     PACK_CHUNK_INTS the arcs come separately, straight to their place,
+     and the exits are merged and the index built while they arrive.
+     Returns the merged pack with its stage-h exit count in *stageNum.
+     p0 is left without data. */
+  pExpGraph_t pTemp;
+  struct pExpGraph_s view0, view1;
+  MPI_Message  *msg;
+  MPI_Request  *req;
+  MPI_Datatype *msgType;
+  MPI_Status    mpstat;
+  int *hdr, *cnt, *off, *scratch, *dst;
+  int vs, as, j, total, entrNum, exitNum, arcNum, pos, siz;
+#if PACK_CHUNK_INTS > 0
+  MPI_Request *arcReq;
+  int **vbuf, *arcOff, *chunkFirst;
+  int chunkNum, i, e, k, got;
+#endif
+
+  vs = peg_GetVSize();
+  as = peg_GetASize();
+
+  msg     = (MPI_Message *)SAFE_MALLOC(num*sizeof(MPI_Message), "(cycle.c) msg");
+  req     = (MPI_Request *)SAFE_MALLOC(num*sizeof(MPI_Request), "(cycle.c) req");
+  msgType = (MPI_Datatype *)SAFE_MALLOC(num*sizeof(MPI_Datatype),
+					"(cycle.c) msgType");
+  hdr = (int *)SAFE_MALLOC(3*num*sizeof(int), "(cycle.c) hdr");
+  cnt = (int *)SAFE_MALLOC(num*sizeof(int), "(cycle.c) cnt");
+  off = (int *)SAFE_MALLOC(num*sizeof(int), "(cycle.c) off");
+
+  total = peg_GetDataInInts(p0);
+  for (j=0 ; j<num ; j++) {
+    MPI_Mprobe(fromList[j], MPI_TAG_PACK, MPI_COMM_WORLD, msg + j, &mpstat);
+    MPI_Get_count(&mpstat, MPI_INT, cnt + j);
+    cnt[j] -= 3;
+    off[j]  = total;
+    total  += cnt[j];
+  }
+
+#if PACK_CHUNK_INTS > 0
+  /* Vertex records to their own buffers, to learn the arc counts */
+  vbuf = (int **)SAFE_MALLOC(num*sizeof(int *), "(cycle.c) vbuf");
+  for (j=0 ; j<num ; j++) {
+    vbuf[j] = (int *)SAFE_MALLOC((cnt[j]+1)*sizeof(int), "(cycle.c) vbuf[j]");
+    msgType[j] = Pack_MsgType(hdr + 3*j, vbuf[j], cnt[j]);
+    MPI_Imrecv(MPI_BOTTOM, 1, msgType[j], msg + j, req + j);
+  }
+  MPI_Waitall(num, req, MPI_STATUSES_IGNORE);
+  chunkNum = 0;
+  for (j=0 ; j<num ; j++) {
+    MPI_Type_free(msgType + j);
+    total    += as*hdr[3*j+2];
+    chunkNum += Pack_ChunkNum(as*hdr[3*j+2]);
+  }
+#endif
+
+  p0->data = (int *)realloc(p0->data, max(total, 1)*sizeof(int));
+  if (p0->data == (int *)NULL)
+    fprintf(errfile,"PE%3d: ERROR: realloc failed in Recv_ExpressMergePacks\n",
+	    MYNODE);
+
+  entrNum = exitNum = arcNum = 0;
+#if PACK_CHUNK_INTS > 0
+  for (j=0 ; j<num ; j++) {
+    entrNum += hdr[3*j];
+    exitNum += hdr[3*j+1];
+  }
+  /* Each sender's arcs go to their final place, behind p0's */
+  arcReq     = (MPI_Request *)SAFE_MALLOC((chunkNum+1)*sizeof(MPI_Request),
+					  "(cycle.c) arcReq");
+  arcOff     = (int *)SAFE_MALLOC(num*sizeof(int), "(cycle.c) arcOff");
+  chunkFirst = (int *)SAFE_MALLOC((num+1)*sizeof(int), "(cycle.c) chunkFirst");
+  pos = vs*(p0->entrNum + p0->exitNum + entrNum + exitNum) + as*p0->arcNum;
+  chunkFirst[0] = 0;
+  for (j=0 ; j<num ; j++) {
+    arcOff[j] = pos;
+    Pack_PostArcs(p0->data + pos, as*hdr[3*j+2], fromList[j],
+		  arcReq + chunkFirst[j]);
+    chunkFirst[j+1] = chunkFirst[j] + Pack_ChunkNum(as*hdr[3*j+2]);
+    pos += as*hdr[3*j+2];
+    arcNum += hdr[3*j+2];
+  }
+#else
+  for (j=0 ; j<num ; j++) {
+    msgType[j] = Pack_MsgType(hdr + 3*j, p0->data + off[j], cnt[j]);
+    MPI_Imrecv(MPI_BOTTOM, 1, msgType[j], msg + j, req + j);
+  }
+  MPI_Waitall(num, req, MPI_STATUSES_IGNORE);
+  for (j=0 ; j<num ; j++) {
+    MPI_Type_free(msgType + j);
+    entrNum += hdr[3*j];
+    exitNum += hdr[3*j+1];
+    arcNum  += hdr[3*j+2];
+  }
+#endif
+
+  pTemp = (pExpGraph_t)SAFE_MALLOC(sizeof(struct pExpGraph_s),
+				   "(cycle.c) pTemp");
+  pTemp->entrNum = p0->entrNum + entrNum;
+  pTemp->exitNum = p0->exitNum + exitNum;
+  pTemp->arcNum  = p0->arcNum  + arcNum;
+  pTemp->data    = p0->data;
+  p0->data       = (int *)NULL;
+  peg_InitAux(pTemp);
+
+  /* Vertex records aside: p0's exits, the others' entrances, their exits */
+  scratch = (int *)SAFE_MALLOC((vs*(p0->exitNum + entrNum + exitNum)+1)*sizeof(int),
+			       "(cycle.c) scratch");
+  memcpy(scratch, pTemp->data + vs*p0->entrNum, vs*p0->exitNum*sizeof(int));
+  dst = scratch + vs*p0->exitNum;
+#if PACK_CHUNK_INTS > 0
+  for (j=0 ; j<num ; j++) {
+    memcpy(dst, vbuf[j], vs*hdr[3*j]*sizeof(int));
+    dst += vs*hdr[3*j];
+  }
+  for (j=0 ; j<num ; j++) {
+    memcpy(dst, vbuf[j] + vs*hdr[3*j], vs*hdr[3*j+1]*sizeof(int));
+    dst += vs*hdr[3*j+1];
+    free(vbuf[j]);
+  }
+  free(vbuf);
+  pos = vs*(pTemp->entrNum + pTemp->exitNum) + as*p0->arcNum;
+#else
+  for (j=0 ; j<num ; j++) {
+    memcpy(dst, pTemp->data + off[j], vs*hdr[3*j]*sizeof(int));
+    dst += vs*hdr[3*j];
+  }
+  for (j=0 ; j<num ; j++) {
+    memcpy(dst, pTemp->data + off[j] + vs*hdr[3*j], vs*hdr[3*j+1]*sizeof(int));
+    dst += vs*hdr[3*j+1];
+  }
+
+  pos = total;
+  for (j=num-1 ; j>=0 ; j--) {
+    siz  = as*hdr[3*j+2];
+    pos -= siz;
+    memmove(pTemp->data + pos, pTemp->data + off[j] + vs*(hdr[3*j] + hdr[3*j+1]),
+	    siz*sizeof(int));
+  }
+#endif
+  siz  = as*p0->arcNum;
+  pos -= siz;
+  memmove(pTemp->data + pos, pTemp->data + vs*(p0->entrNum + p0->exitNum),
+	  siz*sizeof(int));
+
+  memcpy(pTemp->data + vs*p0->entrNum, scratch + vs*p0->exitNum,
+	 vs*entrNum*sizeof(int));
+
+  /* Two views over scratch stand in for p0 and the concatenated packs */
+  view0.entrNum      = 0;
+  view0.exitNum      = p0->exitNum;
+  view0.data         = scratch;
+  view0.deadExitMask = p0->deadExitMask;
+  view1.entrNum      = entrNum;
+  view1.exitNum      = exitNum;
+  view1.data         = scratch + vs*p0->exitNum;
+  view1.deadExitMask = (BOOL *)SAFE_MALLOC((exitNum+1)*sizeof(BOOL),
+					   "(cycle.c) view1.deadExitMask");
+  for (j=0 ; j<exitNum ; j++)
+    view1.deadExitMask[j] = FALSE;
+  if (num > 1)
+    peg_SortExitsByStage(&view1);
+  *stageNum = peg_MergeExits(pTemp, &view0, &view1, h);
+
+  peg_TakeState(pTemp, p0);
+
+#if PACK_CHUNK_INTS > 0
+  /* Index p0's entrances, then each sender's in turn as its chunks
+     come in, in the order peg_BuildIndex would take them */
+  peg_SetArcOffsets(pTemp);
+  peg_BuildExitIndex(pTemp);
+  for (e=0 ; e<p0->entrNum ; e++)
+    peg_IndexAddEntr(pTemp, e);
+  for (j=0 ; j<num ; j++) {
+    k   = chunkFirst[j];
+    got = 0;
+    for (i=0 ; i<hdr[3*j] ; i++, e++) {
+      while (got < pTemp->arcOffset[e+1] - arcOff[j]) {
+	MPI_Wait(arcReq + k, &mpstat);
+	got += Pack_ChunkInts(as*hdr[3*j+2], k - chunkFirst[j]);
+	k++;
+      }
+      peg_IndexAddEntr(pTemp, e);
+    }
+    MPI_Waitall(chunkFirst[j+1] - k, arcReq + k, MPI_STATUSES_IGNORE);
+  }
+  free(chunkFirst);
+  free(arcOff);
+  free(arcReq);
+#endif
+
+  free(view1.deadExitMask);
+  free(scratch);
+  free(off);
+  free(cnt);
+  free(hdr);
+  free(msgType);
+  free(req);
+  free(msg);
+  return (pTemp);
+}
+#endif
+
+int Merge_FanInLog(int maxBytes) {
+  /* log2 of the fan-in for the next stage, given the largest pack */
+  int b;
+
+  b = MERGE_FANIN_LOG;
+  while ((b > 1) &&
+	 (2.0 * (double)(1<<b) * (double)maxBytes > (double)MERGE_FANIN_MAXBYTES))
+    b--;
+  return (b);
+}
+
+void Merge_Plan(pExpGraph_t peg) {
+  /* Place the ranks at the leaves of the merge tree and renumber the
+     pack's adjAssn fields as tree positions.  Every rank gathers the
+     nonzero trans-arc counts between rank pairs, as (count, r, s)
+     records, and builds the same tree bottom up: at each level the
+     clusters are paired by greedy heavy-edge matching, heaviest
+     boundary first, and the second of a pair is shifted into the upper
+     half of the pair's block.  Clusters left with no neighbour to pair
+     with are paired in index order, so with no preference the pairs
+     come out as the rank-bit ones. */
+  int *pos;
+  int logp, size, i, r;
+#if MERGE_HEAVYEDGE
+  int *cnt, *edgeNum, *edgeOff, *edges, *pairs, *clus, *mate, *newIdx;
+  int eNum, myNum, pNum, c, cNew, L, a, b, k;
+#endif
+
+  logp = log2_i(NODES);
+  size = 1<<logp;
+
+  mergeRank = (int *)SAFE_MALLOC(size*sizeof(int), "(cycle.c) mergeRank");
+  pos       = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) pos");
+  for (r=0 ; r<NODES ; r++)
+    pos[r] = r;
+
+#if MERGE_HEAVYEDGE
+  cnt     = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) cnt");
+  edgeNum = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) edgeNum");
+  edgeOff = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) edgeOff");
+  clus    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) clus");
+  mate    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) mate");
+  newIdx  = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) newIdx");
+
+  for (r=0 ; r<NODES ; r++)
+    cnt[r] = 0;
+  for (i=0 ; i<peg->exitNum ; i++)
+    cnt[peg_GetAdjAssn(peg, i, EXITV)]++;
+  myNum = 0;
+  for (r=0 ; r<NODES ; r++)
+    if ((r != MYNODE) && (cnt[r] > 0))
+      myNum++;
+
+  MPI_Allgather(&myNum, 1, MPI_INT, edgeNum, 1, MPI_INT, MPI_COMM_WORLD);
+  eNum = 0;
+  for (r=0 ; r<NODES ; r++) {
+    edgeOff[r]  = 3*eNum;
+    eNum       += edgeNum[r];
+    edgeNum[r] *= 3;
+  }
+  edges = (int *)SAFE_MALLOC((3*eNum + 1)*sizeof(int), "(cycle.c) edges");
+  pairs = (int *)SAFE_MALLOC((3*eNum + 1)*sizeof(int), "(cycle.c) pairs");
+
+  /* This rank's nonzero row, sent from pairs */
+  k = 0;
+  for (r=0 ; r<NODES ; r++)
+    if ((r != MYNODE) && (cnt[r] > 0)) {
+      pairs[k++] = cnt[r];
+      pairs[k++] = MYNODE;
+      pairs[k++] = r;
+    }
+  MPI_Allgatherv(pairs, 3*myNum, MPI_INT, edges, edgeNum, edgeOff, MPI_INT,
+		 MPI_COMM_WORLD);
+
+  for (r=0 ; r<NODES ; r++) {
+    clus[r] = r;
+    pos[r]  = 0;
+  }
+  c = NODES;
+  for (L=0 ; L<logp ; L++) {
+    /* Trans arcs between the clusters of this level, both directions
+       summed under (lower, upper) cluster */
+    pNum = 0;
+    for (i=0 ; i<eNum ; i++) {
+      a = clus[edges[3*i+1]];
+      b = clus[edges[3*i+2]];
+      if (a != b) {
+	pairs[3*pNum]   = edges[3*i];
+	pairs[3*pNum+1] = min(a,b);
+	pairs[3*pNum+2] = max(a,b);
+	pNum++;
+      }
+    }
+    qsort(pairs, pNum, 3*sizeof(int), pairCompareEnds);
+    k = 0;
+    for (i=0 ; i<pNum ; i++) {
+      if ((k > 0) &&
+	  (pairs[3*(k-1)+1] == pairs[3*i+1]) &&
+	  (pairs[3*(k-1)+2] == pairs[3*i+2]))
+	pairs[3*(k-1)] += pairs[3*i];
+      else {
+	pairs[3*k]   = pairs[3*i];
+	pairs[3*k+1] = pairs[3*i+1];
+	pairs[3*k+2] = pairs[3*i+2];
+	k++;
+      }
+    }
+    pNum = k;
+    qsort(pairs, pNum, 3*sizeof(int), pairCompareWeight);
+
+    for (i=0 ; i<c ; i++)
+      mate[i] = -1;
+    for (i=0 ; i<pNum ; i++) {
+      a = pairs[3*i+1];
+      b = pairs[3*i+2];
+      if ((mate[a] < 0) && (mate[b] < 0)) {
+	mate[a] = b;
+	mate[b] = a;
+      }
+    }
+    /* The rest share no trans arcs with each other: pair them in
+       index order */
+    a = -1;
+    for (i=0 ; i<c ; i++)
+      if (mate[i] < 0) {
+	if (a < 0)
+	  a = i;
+	else {
+	  mate[a] = i;
+	  mate[i] = a;
+	  a = -1;
+	}
+      }
+
+    /* A pair's lower cluster keeps its positions and leads the merge;
+       an odd cluster out waits for the next level with an empty half */
+    cNew = 0;
+    for (i=0 ; i<c ; i++)
+      if ((mate[i] < 0) || (i < mate[i])) {
+	newIdx[i] = cNew;
+	if (mate[i] >= 0)
+	  newIdx[mate[i]] = cNew;
+	cNew++;
+      }
+    for (r=0 ; r<NODES ; r++) {
+      a = clus[r];
+      if ((mate[a] >= 0) && (mate[a] < a))
+	pos[r] += 1<<L;
+      clus[r] = newIdx[a];
+    }
+    c = cNew;
+  }
+
+  free(pairs);
+  free(edges);
+  free(newIdx);
+  free(mate);
+  free(clus);
+  free(edgeOff);
+  free(edgeNum);
+  free(cnt);
 #endif
 
-	    for (p=0 ; p<entr0Num ; p++) {
-	      for (s=0 ; s<exit1Num ; s++) {
-#ifdef DEBUG_PRINT
-		fprintf(outfile,"PE%3d: Testing express arc (%3d, %3d) idx %3d -> %3d\n",
-			MYNODE,
-			peg_GetLabel(pTemp, entr0List[p], ENTRV),
-			peg_GetLabel(pTemp, exit1List[s], EXITV),
-			entr0List[p], exit1List[s]);
-		fflush(outfile);
-#endif
-		/* If the arc doesn't exit, add it */
-		exit1Lab = peg_GetLabel(pTemp, exit1List[s], EXITV);
-		if (!peg_CheckArc(pTemp, entr0List[p], exit1Lab)) {
-#ifdef DEBUG_PRINT
-		  fprintf(outfile,"PE%3d: Adding  express arc (%3d, %3d) idx %3d -> %3d\n",
-			MYNODE,
-			peg_GetLabel(pTemp, entr0List[p], ENTRV),
-			peg_GetLabel(pTemp, exit1List[s], EXITV),
-			entr0List[p], exit1List[s]);
-		  fflush(outfile);
-#endif
-		  peg_AddArc(pTemp, entr0List[p], exit1Lab);
-		}
+  for (i=0 ; i<size ; i++)
+    mergeRank[i] = -1;
+  for (r=0 ; r<NODES ; r++)
+    mergeRank[pos[r]] = r;
+  MERGENODE = pos[MYNODE];
+
 #ifdef DEBUG_PRINT
-		else {
-		  fprintf(outfile,"PE%3d: Tossing express arc (%3d, %3d) idx %3d -> %3d\n",
-			MYNODE,
-			peg_GetLabel(pTemp, entr0List[p], ENTRV),
-			peg_GetLabel(pTemp, exit1List[s], EXITV),
-			entr0List[p], exit1List[s]);
-		  fflush(outfile);
-		}
+  if (MYNODE==0)
+    for (i=0 ; i<size ; i++)
+      fprintf(outfile,"PE%3d: merge position %3d: rank %3d\n",
+	      MYNODE, i, mergeRank[i]);
 #endif
-		
-	      } /* foreach exit1 */
-	    } /* foreach entr0 */
 
-	  } /* (exit1Num > 0) */
-	  
-	  free(exit1List);
-	  
-	} /* (entr1ArcNum > 0) */
-	
-      } /* (entr0Num > 0) */
-      
-      free(entr0List);
-      
-      peg_RemoveVertex(pTemp, exit0Idx, EXITV);
-      peg_RemoveVertex(pTemp, entr1Idx, ENTRV);
-	    
-    } /* (curAdjAssn  == MYNODE) */
-    
-  } /* foreach exit0 */
+  /* From here on adjAssn holds a tree position */
+  if (!peg_IsCompact(peg))
+    peg_CleanUp(peg);
+  for (i=0 ; i<peg->entrNum ; i++)
+    peg_SetAdjAssn(peg, i, ENTRV, pos[peg_GetAdjAssn(peg, i, ENTRV)]);
+  for (i=0 ; i<peg->exitNum ; i++)
+    peg_SetAdjAssn(peg, i, EXITV, pos[peg_GetAdjAssn(peg, i, EXITV)]);
+  peg_SortExitsByStage(peg);
 
-  peg_CleanUp(pTemp);
+  free(pos);
+  return;
+}
 
-#ifdef DEBUG_PRINT
-  Print_myExpressPack(pTemp);
-#endif
-  
-  *p0Ptr = pTemp;
+#if MERGE_ASYNC
+int cycleNotice = 1;
 
-  Free_ExpressPack(p0);
+void Merge_AsyncTell(MPI_Request *req) {
+  /* Post a cycle notice to every other rank */
+  int node, k;
+
+  k = 0;
+  for (node=0 ; node<NODES ; node++)
+    if (node != MYNODE)
+      MPI_Isend(&cycleNotice, 1, MPI_INT, node, MPI_TAG_CYCLE,
+		MPI_COMM_WORLD, req + k++);
+  return;
+}
+
+int Merge_AsyncHeard() {
+  /* Take in the cycle notices that have arrived; returns how many */
+  int flag, msg, num;
+  MPI_Status status;
+
+  num = 0;
+  MPI_Iprobe(MPI_ANY_SOURCE, MPI_TAG_CYCLE, MPI_COMM_WORLD, &flag, &status);
+  while (flag) {
+    MPI_Recv(&msg, 1, MPI_INT, status.MPI_SOURCE, MPI_TAG_CYCLE,
+	     MPI_COMM_WORLD, &status);
+    num++;
+    MPI_Iprobe(MPI_ANY_SOURCE, MPI_TAG_CYCLE, MPI_COMM_WORLD, &flag, &status);
+  }
+  return (num);
+}
+
+void Merge_AsyncFinish(MPI_Request *req, int told, int heard) {
+  /* Once the tree is done, count the ranks that sent notices and take
+     in the ones still on the way here */
+  int total, msg;
+  MPI_Status status;
+
+  MPI_Allreduce(&told, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  for ( ; heard < total - told ; heard++)
+    MPI_Recv(&msg, 1, MPI_INT, MPI_ANY_SOURCE, MPI_TAG_CYCLE,
+	     MPI_COMM_WORLD, &status);
+  if (told)
+    MPI_Waitall(NODES-1, req, MPI_STATUSES_IGNORE);
   return;
 }
+#endif
 
 void Merge_ExpressPack(pExpGraph_t *peg) {
-  int h;
+  int h, lo, j, from, num;
   int logp;
-  pExpGraph_t pExpGraph_recv;
-  int found, result;
+#if PACK_ONEMSG && MERGE_INPLACE
+  int stageNum;
+#endif
+  int *fromList;
+  pExpGraph_t *pRecv, pCat;
+  int stat[2], result[2];
+#if MERGE_ASYNC
+  MPI_Request *tellReq;
+  struct pExpGraph_s emptyPack;
+  int told, heard;
+#endif
 
   /* logp is the ceiling of log2(NODES) */
   logp = log2_i(NODES);
 #ifdef DEBUG_PRINT
   MPI_fprintf(outfile,"NODES: %d logp: %d\n",NODES,logp);
 #endif
-  for (h=0 ; h<logp ; h++) {
+  Merge_Plan(*peg);
+  pRecv = (pExpGraph_t *)SAFE_MALLOC((1<<MERGE_FANIN_LOG)*sizeof(pExpGraph_t),
+				     "(cycle.c) pRecv");
+  fromList = (int *)SAFE_MALLOC((1<<MERGE_FANIN_LOG)*sizeof(int),
+				"(cycle.c) fromList");
+#if MERGE_ASYNC
+  tellReq = (MPI_Request *)SAFE_MALLOC(NODES*sizeof(MPI_Request),
+				       "(cycle.c) tellReq");
+  emptyPack.entrNum = 0;
+  emptyPack.exitNum = 0;
+  emptyPack.arcNum  = 0;
+  emptyPack.data    = (int *)NULL;
+  told  = 0;
+  heard = 0;
+#endif
+
+  stat[0] = 0;
+  stat[1] = peg_GetDataInBytes(*peg);
+  MPI_Allreduce(stat, result, 2, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+  /* Each pass covers binary stages lo..h: the group of tree positions
+     that differ only in those bits is merged onto the one with them all
+     clear */
+  for (lo=0 ; lo<logp ; lo=h+1) {
+    h = min(lo + Merge_FanInLog(result[1]), logp) - 1;
 #if PRINT_MERGESIZE
     MPI_Barrier(MPI_COMM_WORLD);
 #endif
-#ifdef DEBUG_PRINT
-    MPI_fprintf(outfile,"lastB(%3d): %3d testB(%3d): %3d \t setB(%3d): %3d clearB(%3d): %3d\n",h,lastB(MYNODE,h),
-		h,testB(MYNODE,h),h,setB(MYNODE,h),h,clearB(MYNODE,h));
+#if MERGE_TEAM && !MERGE_ASYNC
+    /* The whole block, led by its lowest position, which is rank 0 */
+    MPI_Comm_split(MPI_COMM_WORLD, clearLastB(MERGENODE, h), MERGENODE,
+		   &mergeTeam);
+    MPI_Comm_size(mergeTeam, &mergeTeamSize);
 #endif
-    if (lastB(MYNODE, h)==0) {
+    stat[1] = 0;
+    if (lastB(MERGENODE, lo)==0) {
 #if PRINT_MERGESIZE
       fprintf(outfile,"PE%3d: [%3d] entr: %12d exit: %12d exarcs: %12d\n",
-	      MYNODE, h, (*peg)->entrNum, (*peg)->exitNum, (*peg)->arcNum);
+	      MYNODE, h, (*peg)->entrNum - (*peg)->deadEntr,
+	      (*peg)->exitNum - (*peg)->deadExit,
+	      (*peg)->arcNum - (*peg)->deadArc + (*peg)->newArc);
+#endif
+      if (clearLastB(MERGENODE, h) == MERGENODE) {
+	/* Positions left empty when NODES is not a power of two are
+	   skipped; with none filled we sit idle this stage */
+	num = 0;
+	for (j=1 ; j<(1<<(h-lo+1)) ; j++) {
+	  from = mergeRank[MERGENODE + (j<<lo)];
+	  if (from >= 0) {
+#ifdef DEBUG_PRINT
+	    fprintf(outfile,"PE%3d: (h:%3d) I'm receiving from PE%3d\n",
+		    MYNODE, h, from);
+	    fflush(outfile);
 #endif
-      if (testB(MYNODE,h)==0) {
-	/* Make sure that if we're not using a power-of-two nodes
-	   that we just sit idle for a stage where our partner is missing */
-	if (setB(MYNODE,h) < NODES) {
+	    fromList[num] = from;
+	    num++;
+	  }
+	}
+#if MERGE_ASYNC
+	heard += Merge_AsyncHeard();
+	if ((CYCLE_FOUND==TRUE) || (heard > 0)) {
+	  /* The answer is known: drop the packs unmerged */
+	  for (j=0 ; j<num ; j++) {
+	    Recv_ExpressPack(&pCat, fromList[j]);
+	    Free_ExpressPack(pCat);
+	  }
+	  num = 0;
+	}
+#endif
+	if (num > 0) {
 #ifdef DEBUG_PRINT
 	  fprintf(outfile,"PE%3d: BEFORE MERGE\n",MYNODE);
 	  Print_myExpressPack(*peg);
 	  fprintf(outfile,"PE%3d: BEFORE MERGE DONE\n",MYNODE);
 	  fflush(outfile);
 #endif
-#ifdef DEBUG_PRINT
-	  fprintf(outfile,"PE%3d: (h:%3d) I'm receiving from PE%3d\n",
-		  MYNODE, h, setB(MYNODE,h));
-	  fflush(outfile);
+#if PACK_ONEMSG && MERGE_INPLACE
+	  pCat = Recv_ExpressMergePacks(*peg, fromList, num, h, &stageNum);
+	  ExpressMerge_Stage(peg, pCat, h, stageNum);
+#else
+	  for (j=0 ; j<num ; j++)
+	    Recv_ExpressPack(pRecv + j, fromList[j]);
+	  if (num == 1)
+	    pCat = pRecv[0];
+	  else {
+	    pCat = peg_ConcatPacks(pRecv, num);
+	    for (j=0 ; j<num ; j++)
+	      Free_ExpressPack(pRecv[j]);
+	  }
+	  ExpressMerge(peg, pCat, h);
+	  Free_ExpressPack(pCat);
 #endif
-	  Recv_ExpressPack(&pExpGraph_recv, setB(MYNODE,h));
-	  ExpressMerge(peg, pExpGraph_recv, h);
-
 #ifdef DEBUG_PRINT
 	  fprintf(outfile,"PE%3d: AFTER MERGE\n",MYNODE);
 	  Print_myExpressPack(*peg);
 	  fprintf(outfile,"PE%3d: AFTER MERGE DONE\n",MYNODE);
 	  fflush(outfile);
-#endif
-	  Free_ExpressPack(pExpGraph_recv);
-#ifdef DEBUG_PRINT
-	  fprintf(outfile,"PE%3d: AFTER FREEING EXPRESSPACK MERGE\n",MYNODE);
-	  Print_myExpressPack(*peg);
-	  fprintf(outfile,"PE%3d: AFTER FREEING EXPRESSPACK MERGE DONE\n",MYNODE);
-	  fflush(outfile);
 #endif
 	}
+#if MERGE_ASYNC
+	if ((CYCLE_FOUND==TRUE) && !told) {
+	  Merge_AsyncTell(tellReq);
+	  told = 1;
+	}
+#endif
+	stat[1] = peg_GetDataInBytes(*peg);
       }
       else {
 #ifdef DEBUG_PRINT
 	fprintf(outfile,"PE%3d: (h:%3d) I'm sending to PE%3d\n",
-		MYNODE, h, clearB(MYNODE,h));
+		MYNODE, h, mergeRank[clearLastB(MERGENODE, h)]);
 	fflush(outfile);
 #endif
-	Send_ExpressPack(*peg, clearB(MYNODE,h));
+#if MERGE_ASYNC
+	heard += Merge_AsyncHeard();
+	if ((CYCLE_FOUND==TRUE) || (heard > 0))
+	  Send_ExpressPack(&emptyPack, mergeRank[clearLastB(MERGENODE, h)]);
+	else
+#endif
+	{
+	  if (!peg_IsCompact(*peg))
+	    peg_CleanUp(*peg);
+	  Send_ExpressPack(*peg, mergeRank[clearLastB(MERGENODE, h)]);
+	}
+      }
+    }
+#if MERGE_TEAM && !MERGE_ASYNC
+    /* The rest of the block serves the leader's dense merges above
+       until it lets them go */
+    if (mergeTeamSize > 1) {
+      if (clearLastB(MERGENODE, h) == MERGENODE)
+	Merge_TeamRelease();
+      else
+	Merge_TeamServe();
+    }
+    MPI_Comm_free(&mergeTeam);
+    mergeTeamSize = 1;
+#endif
+#if !MERGE_ASYNC
+    /* One reduction per stage: a cycle anywhere, and the largest pack
+       left for sizing the next stage */
+    stat[0] = (CYCLE_FOUND==TRUE)?1:0;
+    MPI_Allreduce(stat, result, 2, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (result[0])
+      break;
+#endif
+  }
+#if MERGE_ASYNC
+  Merge_AsyncFinish(tellReq, told, heard);
+  free(tellReq);
+#endif
+  free(fromList);
+  free(pRecv);
+  free(mergeRank);
+  return;
+}
+
+/*************************************************************************/
+/* SCC engine.  Each exit x leads along its trans arc to one entrance    */
+/* on node adjAssn(x), whose express arcs lead to exits there; a cycle   */
+/* that crosses nodes is a cycle in this graph over the exits.  Every   */
+/* round trims exits with no live pred or succ, colours each exit with  */
+/* the largest id that reaches it, and looks at the roots (exits whose  */
+/* colour is their own id): a root with a pred of its own colour lies   */
+/* on a cycle.  Otherwise the roots are dropped and the next round      */
+/* starts.  Each step is one MPI_Alltoallv over a fixed pattern.        */
+/*************************************************************************/
+
+sccPlan_t Scc_PlanInit(pExpGraph_t peg) {
+  sccPlan_t plan;
+  int i, k, node, *sendKey, *recvKey;
+
+  plan = (sccPlan_t)SAFE_MALLOC(sizeof(struct sccPlan_s), "(cycle.c) plan");
+  plan->sendNum  = peg->exitNum;
+  plan->sendExit = (int *)SAFE_MALLOC((peg->exitNum+1)*sizeof(int),
+				      "(cycle.c) plan->sendExit");
+  plan->sendCnt  = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) plan->sendCnt");
+  plan->sendOff  = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) plan->sendOff");
+  plan->recvCnt  = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) plan->recvCnt");
+  plan->recvOff  = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) plan->recvOff");
+
+  /* Exits grouped by the node holding their entrance */
+  for (node=0 ; node<NODES ; node++)
+    plan->sendCnt[node] = 0;
+  for (i=0 ; i<peg->exitNum ; i++)
+    plan->sendCnt[peg_GetAdjAssn(peg, i, EXITV)]++;
+  plan->sendOff[0] = 0;
+  for (node=1 ; node<NODES ; node++)
+    plan->sendOff[node] = plan->sendOff[node-1] + plan->sendCnt[node-1];
+  for (i=0 ; i<peg->exitNum ; i++) {
+    node = peg_GetAdjAssn(peg, i, EXITV);
+    plan->sendExit[plan->sendOff[node]++] = i;
+  }
+  for (node=0 ; node<NODES ; node++)
+    plan->sendOff[node] -= plan->sendCnt[node];
+
+  MPI_Alltoall(plan->sendCnt, 1, MPI_INT, plan->recvCnt, 1, MPI_INT,
+	       MPI_COMM_WORLD);
+  plan->recvOff[0] = 0;
+  for (node=1 ; node<NODES ; node++)
+    plan->recvOff[node] = plan->recvOff[node-1] + plan->recvCnt[node-1];
+  plan->recvNum = plan->recvOff[NODES-1] + plan->recvCnt[NODES-1];
+
+  /* Send each entrance's (label, adj) key once and resolve it here */
+  sendKey = (int *)SAFE_MALLOC((2*plan->sendNum+1)*sizeof(int), "(cycle.c) sendKey");
+  recvKey = (int *)SAFE_MALLOC((2*plan->recvNum+1)*sizeof(int), "(cycle.c) recvKey");
+  for (k=0 ; k<plan->sendNum ; k++) {
+    i = plan->sendExit[k];
+    sendKey[2*k]   = peg_GetAdj  (peg, i, EXITV);
+    sendKey[2*k+1] = peg_GetLabel(peg, i, EXITV);
+  }
+  for (node=0 ; node<NODES ; node++) {
+    plan->sendCnt[node] *= 2; plan->sendOff[node] *= 2;
+    plan->recvCnt[node] *= 2; plan->recvOff[node] *= 2;
+  }
+  MPI_Alltoallv(sendKey, plan->sendCnt, plan->sendOff, MPI_INT,
+		recvKey, plan->recvCnt, plan->recvOff, MPI_INT,
+		MPI_COMM_WORLD);
+  for (node=0 ; node<NODES ; node++) {
+    plan->sendCnt[node] /= 2; plan->sendOff[node] /= 2;
+    plan->recvCnt[node] /= 2; plan->recvOff[node] /= 2;
+  }
+
+  plan->recvEntr = (int *)SAFE_MALLOC((plan->recvNum+1)*sizeof(int),
+				      "(cycle.c) plan->recvEntr");
+  for (k=0 ; k<plan->recvNum ; k++)
+    plan->recvEntr[k] = peg_FindEntrIdx(peg, recvKey[2*k], recvKey[2*k+1]);
+
+  free(recvKey);
+  free(sendKey);
+  return (plan);
+}
+
+void Scc_Forward(sccPlan_t plan, int *sendVal, int *recvVal) {
+  /* Values by send position go to the entrances at the other end */
+  MPI_Alltoallv(sendVal, plan->sendCnt, plan->sendOff, MPI_INT,
+		recvVal, plan->recvCnt, plan->recvOff, MPI_INT,
+		MPI_COMM_WORLD);
+  return;
+}
+
+void Scc_Backward(sccPlan_t plan, int *recvVal, int *sendVal) {
+  /* Values by receive position go back to the exits that sent them */
+  MPI_Alltoallv(recvVal, plan->recvCnt, plan->recvOff, MPI_INT,
+		sendVal, plan->sendCnt, plan->sendOff, MPI_INT,
+		MPI_COMM_WORLD);
+  return;
+}
+
+void Scc_PlanFree(sccPlan_t plan) {
+  free(plan->recvEntr);
+  free(plan->recvOff);
+  free(plan->recvCnt);
+  free(plan->sendOff);
+  free(plan->sendCnt);
+  free(plan->sendExit);
+  free(plan);
+  return;
+}
+
+int Select_Engine(pExpGraph_t peg, int n) {
+  /* Pick the engine from the global boundary size */
+  int engine, boundary, total;
+
+  engine = CYCLE_ENGINE;
+  if (engine == ENGINE_AUTO) {
+    boundary = (peg->entrNum - peg->deadEntr) + (peg->exitNum - peg->deadExit);
+    MPI_Allreduce(&boundary, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    engine = ((double)total >= ENGINE_SCC_BOUNDARY*(double)n) ?
+      ENGINE_SCC : ENGINE_MERGE;
+  }
+#if PRINT_MERGESIZE
+  if (MYNODE==0)
+    fprintf(outfile,"PE%3d: Engine: %s\n",MYNODE,
+	    (engine==ENGINE_SCC)?"SCC":"MERGE");
+#endif
+  return (engine);
+}
+
+void Scc_ExpressPack(pExpGraph_t peg) {
+  sccPlan_t plan;
+  pegIndex_t ix;
+  BOOL built;
+  int *succStart, *succList, *predStart, *predList;
+  int *live, *color, *sendVal, *recvVal, *entrVal;
+  int i, k, x, e, slot, head, arcnum, num, base, changed, total;
+  int found, result, rounds;
+
+  if (peg->arcOffset == (int *)NULL)
+    peg_SetArcOffsets(peg);
+  built = (peg->index == (pegIndex_t)NULL);
+  if (built)
+    peg_BuildIndex(peg);
+  ix = peg->index;
+
+  plan = Scc_PlanInit(peg);
+
+  /* Exits reached from each entrance, and entrances reaching each exit */
+  succStart = (int *)SAFE_MALLOC((peg->entrNum+1)*sizeof(int), "(cycle.c) succStart");
+  predStart = (int *)SAFE_MALLOC((peg->exitNum+1)*sizeof(int), "(cycle.c) predStart");
+  for (x=0 ; x<=peg->exitNum ; x++)
+    predStart[x] = 0;
+  num = 0;
+  for (e=0 ; e<peg->entrNum ; e++) {
+    succStart[e] = num;
+    if (peg->deadEntrMask[e] == TRUE)
+      continue;
+    arcnum = peg_GetArcNum(peg, e, ENTRV);
+    for (k=0 ; k<arcnum ; k++) {
+      head = peg_GetArcHead(peg, e, k);
+      if (head < 0)
+	continue;
+      slot = peg_IndexLabelSlot(ix, head, FALSE);
+      if (slot < 0)
+	continue;
+      for (x=ix->labelExit[slot] ; x>=0 ; x=ix->exitNext[x]) {
+	predStart[x]++;
+	num++;
+      }
+    }
+  }
+  succStart[peg->entrNum] = num;
+  succList = (int *)SAFE_MALLOC((num+1)*sizeof(int), "(cycle.c) succList");
+  predList = (int *)SAFE_MALLOC((num+1)*sizeof(int), "(cycle.c) predList");
+  for (x=1 ; x<=peg->exitNum ; x++)
+    predStart[x] += predStart[x-1];
+  for (e=peg->entrNum-1 ; e>=0 ; e--) {
+    k = succStart[e+1];
+    if (peg->deadEntrMask[e] == TRUE)
+      continue;
+    arcnum = peg_GetArcNum(peg, e, ENTRV);
+    for (i=arcnum-1 ; i>=0 ; i--) {
+      head = peg_GetArcHead(peg, e, i);
+      if (head < 0)
+	continue;
+      slot = peg_IndexLabelSlot(ix, head, FALSE);
+      if (slot < 0)
+	continue;
+      for (x=ix->labelExit[slot] ; x>=0 ; x=ix->exitNext[x]) {
+	succList[--k] = x;
+	predList[--predStart[x]] = e;
+      }
+    }
+  }
+  /* predStart[x] now starts x's preds, predStart[x+1] ends them */
+  if (built)
+    peg_FreeIndex(peg);
+
+  live    = (int *)SAFE_MALLOC((peg->exitNum+1)*sizeof(int), "(cycle.c) live");
+  color   = (int *)SAFE_MALLOC((peg->exitNum+1)*sizeof(int), "(cycle.c) color");
+  sendVal = (int *)SAFE_MALLOC((plan->sendNum+1)*sizeof(int), "(cycle.c) sendVal");
+  recvVal = (int *)SAFE_MALLOC((plan->recvNum+1)*sizeof(int), "(cycle.c) recvVal");
+  entrVal = (int *)SAFE_MALLOC((peg->entrNum+1)*sizeof(int), "(cycle.c) entrVal");
+
+  /* Global exit ids: this node's exits follow those of lower nodes */
+  base = 0;
+  MPI_Exscan(&peg->exitNum, &base, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  if (MYNODE==0)
+    base = 0;
+
+  for (x=0 ; x<peg->exitNum ; x++)
+    live[x] = (peg->deadExitMask[x] == FALSE);
+
+  found  = 0;
+  rounds = 0;
+  while (!found) {
+    rounds++;
+
+    /* Trim: an exit with no live pred entrance, or whose entrance leads
+       to no live exit, is on no cycle */
+    do {
+      for (k=0 ; k<plan->sendNum ; k++)
+	sendVal[k] = live[plan->sendExit[k]];
+      Scc_Forward(plan, sendVal, recvVal);
+      for (e=0 ; e<peg->entrNum ; e++)
+	entrVal[e] = 0;
+      for (k=0 ; k<plan->recvNum ; k++)
+	if (plan->recvEntr[k] >= 0)
+	  entrVal[plan->recvEntr[k]] = recvVal[k];
+      for (k=0 ; k<plan->recvNum ; k++) {
+	e = plan->recvEntr[k];
+	recvVal[k] = 0;
+	if ((e >= 0) && entrVal[e])
+	  for (i=succStart[e] ; (i<succStart[e+1]) && !recvVal[k] ; i++)
+	    recvVal[k] = live[succList[i]];
+      }
+      Scc_Backward(plan, recvVal, sendVal);
+
+      changed = 0;
+      for (k=0 ; k<plan->sendNum ; k++) {
+	x = plan->sendExit[k];
+	if (!live[x])
+	  continue;
+	num = 0;
+	for (i=predStart[x] ; (i<predStart[x+1]) && !num ; i++)
+	  num = entrVal[predList[i]];
+	if ((num == 0) || (sendVal[k] == 0)) {
+	  live[x] = 0;
+	  changed++;
+	}
+      }
+      MPI_Allreduce(&changed, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    } while (total > 0);
+
+    num = 0;
+    for (x=0 ; x<peg->exitNum ; x++)
+      num += live[x];
+    MPI_Allreduce(&num, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+#ifdef DEBUG_PRINT
+    if (MYNODE==0)
+      fprintf(outfile,"PE%3d: SCC round %d live exits: %d\n",MYNODE,rounds,total);
+#endif
+    if (total == 0)
+      break;
+
+    /* Colour: carry the largest id along the arcs until nothing changes.
+       The last pass leaves each entrance holding its exit's colour. */
+    for (x=0 ; x<peg->exitNum ; x++)
+      color[x] = live[x] ? base + x : -1;
+    do {
+      for (k=0 ; k<plan->sendNum ; k++)
+	sendVal[k] = color[plan->sendExit[k]];
+      Scc_Forward(plan, sendVal, recvVal);
+      for (e=0 ; e<peg->entrNum ; e++)
+	entrVal[e] = -1;
+      for (k=0 ; k<plan->recvNum ; k++)
+	if (plan->recvEntr[k] >= 0)
+	  entrVal[plan->recvEntr[k]] = recvVal[k];
+      changed = 0;
+      for (e=0 ; e<peg->entrNum ; e++) {
+	if (entrVal[e] < 0)
+	  continue;
+	for (i=succStart[e] ; i<succStart[e+1] ; i++) {
+	  x = succList[i];
+	  if (live[x] && (entrVal[e] > color[x])) {
+	    color[x] = entrVal[e];
+	    changed++;
+	  }
+	}
+      }
+      MPI_Allreduce(&changed, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    } while (total > 0);
+
+    /* A root reaches everything of its colour, so a pred of that colour
+       closes a cycle through it */
+    for (x=0 ; (x<peg->exitNum) && !found ; x++) {
+      if (!live[x] || (color[x] != base + x))
+	continue;
+      for (i=predStart[x] ; i<predStart[x+1] ; i++) {
+	if (entrVal[predList[i]] == color[x]) {
+	  fprintf(outfile,"PE%3d: HALT: CYCLE DETECTED DURING SCC SEARCH (%3d)\n",
+		  MYNODE, peg_GetLabel(peg, x, EXITV));
+	  CYCLE_FOUND = TRUE;
+	  found = 1;
+	  break;
+	}
       }
     }
-#if 1
-    found = (CYCLE_FOUND==TRUE)?1:0;
     MPI_Allreduce(&found, &result, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
-    if (result)
-      return;
-#else
-    MPI_Barrier(MPI_COMM_WORLD);
+    found = result;
+
+    /* Each root is an SCC of its own: drop them */
+    for (x=0 ; x<peg->exitNum ; x++)
+      if (live[x] && (color[x] == base + x))
+	live[x] = 0;
+  }
+
+#if PRINT_MERGESIZE
+  if (MYNODE==0)
+    fprintf(outfile,"PE%3d: SCC rounds: %d\n",MYNODE,rounds);
+#endif
+
+  free(entrVal);
+  free(recvVal);
+  free(sendVal);
+  free(color);
+  free(live);
+  free(predList);
+  free(succList);
+  free(predStart);
+  free(succStart);
+  Scc_PlanFree(plan);
+  return;
+}
+
+/*************************************************************************/
+/* Peeling engine.  Each node runs Kahn's algorithm on its own vertices: */
+/* a vertex whose preds are all peeled is peeled, and its arcs to other  */
+/* nodes become in-degree decrements sent to the owner with MPI_Issend.  */
+/* A round ends the NBX way: a node whose sends have all been matched    */
+/* enters MPI_Ibarrier and keeps receiving until the barrier completes.  */
+/* Decrements made after entering the barrier wait for the next round.   */
+/* A vertex that is never peeled lies on a cycle or after one.           */
+/*************************************************************************/
+
+void Peel_Push(peelState_t st, int idx) {
+  st->queue[st->qNum++] = idx;
+  return;
+}
+
+void Peel_Run(vertexList_t verts, peelState_t st) {
+  /* Peel until the local queue is empty, buffering remote decrements */
+  int i, v, w, node;
+  vertex_t vp;
+
+  while (st->qNum > 0) {
+    v  = st->queue[--st->qNum];
+    vp = verts->vlist + v;
+    st->peeled++;
+    for (i=0 ; i<vp->arcs ; i++) {
+      node = vp->alist[i].assn;
+      if (node == MYNODE) {
+	w = localIndex(verts, vp->alist[i].head);
+	if (--st->indeg[w] == 0)
+	  Peel_Push(st, w);
+      }
+      else {
+	if (st->bufNum[node] == st->bufMax[node]) {
+	  st->bufMax[node] = (st->bufMax[node] > 0) ? 2*st->bufMax[node] : 64;
+	  st->buf[node] = (int *)realloc(st->buf[node], st->bufMax[node]*sizeof(int));
+	  if (st->buf[node] == (int *)NULL)
+	    fprintf(errfile,"PE%3d: ERROR: realloc failed in Peel_Run\n",MYNODE);
+	}
+	st->buf[node][st->bufNum[node]++] = vp->alist[i].head;
+      }
+    }
+  }
+  return;
+}
+
+void Peel_Post(peelState_t st) {
+  /* Send every node its buffered decrements; the buffer goes with the
+     request until the send is matched */
+  int node;
+
+  for (node=0 ; node<NODES ; node++) {
+    if (st->bufNum[node] == 0)
+      continue;
+    if (st->reqNum == st->reqMax) {
+      st->reqMax = (st->reqMax > 0) ? 2*st->reqMax : NODES;
+      st->req    = (MPI_Request *)realloc(st->req, st->reqMax*sizeof(MPI_Request));
+      st->reqBuf = (int **)realloc(st->reqBuf, st->reqMax*sizeof(int *));
+      if ((st->req == (MPI_Request *)NULL) || (st->reqBuf == (int **)NULL))
+	fprintf(errfile,"PE%3d: ERROR: realloc failed in Peel_Post\n",MYNODE);
+    }
+    MPI_Issend(st->buf[node], st->bufNum[node], MPI_INT, node, MPI_TAG_PEEL,
+	       MPI_COMM_WORLD, st->req + st->reqNum);
+    st->reqBuf[st->reqNum++] = st->buf[node];
+    st->buf[node]    = (int *)NULL;
+    st->bufNum[node] = 0;
+    st->bufMax[node] = 0;
+  }
+  return;
+}
+
+BOOL Peel_SendsDone(peelState_t st) {
+  int i, flag;
+
+  if (st->reqNum == 0)
+    return (TRUE);
+  MPI_Testall(st->reqNum, st->req, &flag, MPI_STATUSES_IGNORE);
+  if (!flag)
+    return (FALSE);
+  for (i=0 ; i<st->reqNum ; i++)
+    free(st->reqBuf[i]);
+  st->reqNum = 0;
+  return (TRUE);
+}
+
+void Peel_Recv(vertexList_t verts, peelState_t st) {
+  /* Apply every decrement message that has arrived */
+  MPI_Status status;
+  int flag, cnt, i, w, *msg;
+
+  MPI_Iprobe(MPI_ANY_SOURCE, MPI_TAG_PEEL, MPI_COMM_WORLD, &flag, &status);
+  while (flag) {
+    MPI_Get_count(&status, MPI_INT, &cnt);
+    msg = (int *)SAFE_MALLOC((cnt+1)*sizeof(int), "(cycle.c) msg");
+    MPI_Recv(msg, cnt, MPI_INT, status.MPI_SOURCE, MPI_TAG_PEEL,
+	     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    for (i=0 ; i<cnt ; i++) {
+      w = localIndex(verts, msg[i]);
+      if (--st->indeg[w] == 0)
+	Peel_Push(st, w);
+    }
+    free(msg);
+    MPI_Iprobe(MPI_ANY_SOURCE, MPI_TAG_PEEL, MPI_COMM_WORLD, &flag, &status);
+  }
+  return;
+}
+
+void Peel_Input(vertexList_t verts) {
+  peelState_t st;
+  MPI_Request barrier;
+  int i, j, node, done, pending, total, left, rounds;
+  int *send_cnt, *send_offset, *recv_cnt, *recv_offset, *sendHead, *recvHead;
+  BOOL inBarrier;
+  vertex_t v;
+
+#if PRINT_MERGESIZE
+  if (MYNODE==0)
+    fprintf(outfile,"PE%3d: Engine: PEEL\n",MYNODE);
 #endif
+
+  st = (peelState_t)SAFE_MALLOC(sizeof(struct peelState_s), "(cycle.c) st");
+  st->num    = verts->num;
+  st->indeg  = (int *)SAFE_MALLOC((st->num+1)*sizeof(int), "(cycle.c) st->indeg");
+  st->queue  = (int *)SAFE_MALLOC((st->num+1)*sizeof(int), "(cycle.c) st->queue");
+  st->buf    = (int **)SAFE_MALLOC(NODES*sizeof(int *), "(cycle.c) st->buf");
+  st->bufNum = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) st->bufNum");
+  st->bufMax = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) st->bufMax");
+  st->qNum   = 0;
+  st->peeled = 0;
+  st->reqNum = 0;
+  st->reqMax = 0;
+  st->req    = (MPI_Request *)NULL;
+  st->reqBuf = (int **)NULL;
+  for (node=0 ; node<NODES ; node++) {
+    st->buf[node]    = (int *)NULL;
+    st->bufNum[node] = 0;
+    st->bufMax[node] = 0;
+  }
+
+  /* In-degrees: local arcs here, trans arcs sent once to the head's node */
+  send_cnt    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) send_cnt");
+  send_offset = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) send_offset");
+  recv_cnt    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) recv_cnt");
+  recv_offset = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycle.c) recv_offset");
+  for (i=0 ; i<st->num ; i++)
+    st->indeg[i] = 0;
+  for (node=0 ; node<NODES ; node++)
+    send_cnt[node] = 0;
+  for (i=0 ; i<st->num ; i++) {
+    v = verts->vlist + i;
+    for (j=0 ; j<v->arcs ; j++) {
+      if (v->alist[j].assn == MYNODE)
+	st->indeg[localIndex(verts, v->alist[j].head)]++;
+      else
+	send_cnt[v->alist[j].assn]++;
+    }
+  }
+  send_offset[0] = 0;
+  for (node=1 ; node<NODES ; node++)
+    send_offset[node] = send_offset[node-1] + send_cnt[node-1];
+  total = send_offset[NODES-1] + send_cnt[NODES-1];
+  sendHead = (int *)SAFE_MALLOC((total+1)*sizeof(int), "(cycle.c) sendHead");
+  for (i=0 ; i<st->num ; i++) {
+    v = verts->vlist + i;
+    for (j=0 ; j<v->arcs ; j++)
+      if (v->alist[j].assn != MYNODE)
+	sendHead[send_offset[v->alist[j].assn]++] = v->alist[j].head;
   }
+  for (node=0 ; node<NODES ; node++)
+    send_offset[node] -= send_cnt[node];
+
+  MPI_Alltoall(send_cnt, 1, MPI_INT, recv_cnt, 1, MPI_INT, MPI_COMM_WORLD);
+  recv_offset[0] = 0;
+  for (node=1 ; node<NODES ; node++)
+    recv_offset[node] = recv_offset[node-1] + recv_cnt[node-1];
+  total = recv_offset[NODES-1] + recv_cnt[NODES-1];
+  recvHead = (int *)SAFE_MALLOC((total+1)*sizeof(int), "(cycle.c) recvHead");
+  MPI_Alltoallv(sendHead, send_cnt, send_offset, MPI_INT,
+		recvHead, recv_cnt, recv_offset, MPI_INT, MPI_COMM_WORLD);
+  for (i=0 ; i<total ; i++)
+    st->indeg[localIndex(verts, recvHead[i])]++;
+  free(recvHead);
+  free(sendHead);
+  free(recv_offset);
+  free(recv_cnt);
+  free(send_offset);
+  free(send_cnt);
+
+  for (i=0 ; i<st->num ; i++)
+    if (st->indeg[i] == 0)
+      Peel_Push(st, i);
+
+  rounds = 0;
+  do {
+    rounds++;
+    Peel_Run(verts, st);
+    Peel_Post(st);
+    inBarrier = FALSE;
+    done = 0;
+    while (!done) {
+      Peel_Recv(verts, st);
+      Peel_Run(verts, st);
+      if (!inBarrier) {
+	Peel_Post(st);
+	if (Peel_SendsDone(st)) {
+	  MPI_Ibarrier(MPI_COMM_WORLD, &barrier);
+	  inBarrier = TRUE;
+	}
+      }
+      else
+	MPI_Test(&barrier, &done, MPI_STATUS_IGNORE);
+    }
+    /* Every send of this round has been received; anything still
+       buffered starts the next one */
+    pending = 0;
+    for (node=0 ; node<NODES ; node++)
+      pending += st->bufNum[node];
+    MPI_Allreduce(&pending, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  } while (total > 0);
+
+  left = st->num - st->peeled;
+  if (left > 0) {
+    fprintf(outfile,"PE%3d: HALT: CYCLE DETECTED DURING PEELING (%d vertices left)\n",
+	    MYNODE, left);
+    CYCLE_FOUND = TRUE;
+  }
+#if PRINT_MERGESIZE
+  if (MYNODE==0)
+    fprintf(outfile,"PE%3d: PEEL rounds: %d\n",MYNODE,rounds);
+#endif
+
+  for (node=0 ; node<NODES ; node++)
+    free(st->buf[node]);
+  free(st->reqBuf);
+  free(st->req);
+  free(st->bufMax);
+  free(st->bufNum);
+  free(st->buf);
+  free(st->queue);
+  free(st->indeg);
+  free(st);
   return;
 }
 
@@ -2239,15 +5454,20 @@ void main(int argc, char **argv) {
   vertexList_t myVerts;
   int initTransArcCount, termTransArcCount;
   transArc_t *initTransArcs, *termTransArcs;
+#if !DIRECT_PACK
   eGraph_t expGraph;
+#endif
   pExpGraph_t pExpGraph;
   int found, result;
+  int backArcs;
 
   timer_init();
   
   MPI_Init(&argc, &argv);
   MPI_Comm_rank(MPI_COMM_WORLD, &MYNODE);
   MPI_Comm_size(MPI_COMM_WORLD, &NODES);
+  MERGENODE = MYNODE;
+  mergeTeamSize = 1;
 
   outfile = stdout;
 #if 0
@@ -2291,12 +5511,22 @@ void main(int argc, char **argv) {
   timer_mark("Print Input");
 #endif
 
+  backArcs = 1;
+#if BACKARC_PRUNE
+  backArcs = Backarc_Restrict(myVerts);
+  timer_mark("Backarc_Restrict");
+#endif
+
   Find_Local_Cycles(myVerts);
   timer_mark("Find Local Cycles");
 
   found = (CYCLE_FOUND==TRUE)?1:0;
   MPI_Allreduce(&found, &result, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
-  if (!result) {
+  if ((!result) && (backArcs > 0) && (CYCLE_ENGINE == ENGINE_PEEL)) {
+    Peel_Input(myVerts);
+    timer_mark("Peel_Input");
+  }
+  else if ((!result) && (backArcs > 0)) {
   
     Discovery(myVerts,
 	      &initTransArcCount, 
@@ -2305,8 +5535,17 @@ void main(int argc, char **argv) {
 	      &termTransArcs);
     timer_mark("Discovery");
 
+#if DIRECT_PACK
+    Create_ExpressPack_Direct(myVerts,
+			      initTransArcCount,
+			      initTransArcs,
+			      termTransArcCount,
+			      termTransArcs,
+			      &pExpGraph);
+    timer_mark("Create_ExpressPack");
+#else
     Create_Express(myVerts,
-		   initTransArcCount, 
+		   initTransArcCount,
 		   initTransArcs,
 		   termTransArcCount,
 		   termTransArcs,
@@ -2317,21 +5556,36 @@ void main(int argc, char **argv) {
     Print_Express(expGraph);
     timer_mark("Print_Express");
 #endif
-  
+
     Create_ExpressPack(expGraph, &pExpGraph);
     timer_mark("Create_ExpressPack");
+#endif
+
+#if PRUNE_DEADENDS
+    if (peg_Prune(pExpGraph) > 0)
+      peg_CleanUp(pExpGraph);
+    timer_mark("Prune_ExpressPack");
+#endif
 
 #ifdef DEBUG_PRINT
     Print_ExpressPack(pExpGraph);
     timer_mark("Print_ExpressPack");
 #endif
   
-    Merge_ExpressPack(&pExpGraph);
-    timer_mark("Merge_ExpressPack");
+    if (Select_Engine(pExpGraph, n) == ENGINE_SCC) {
+      Scc_ExpressPack(pExpGraph);
+      timer_mark("Scc_ExpressPack");
+    }
+    else {
+      Merge_ExpressPack(&pExpGraph);
+      timer_mark("Merge_ExpressPack");
+    }
 
     Free_ExpressPack(pExpGraph);
-    
+
+#if !DIRECT_PACK
     Free_Express(expGraph);
+#endif
     free(termTransArcs);
     free(initTransArcs);
   }
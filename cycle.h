@@ -80,6 +80,7 @@ typedef struct labelLookup_s {
 } *labelLookup_t;
 
 #define ENTR_LUT 0
+#define EXIT_DIRECT 1
 typedef struct eGraph_s {
   int entrNum;           /* Number of entrance vertices */
   int exitNum;           /* Number of exit vertices */
@@ -89,21 +90,78 @@ typedef struct eGraph_s {
   labelLookup_t entrLUT; /* Table from vertex label -> express vertex */
   int entrLUTNum;        /* Number of filled LUT entries */
 #endif
+#if EXIT_DIRECT
+  expVertex_t *exitDirect; /* Table from local vertex index -> exit vertex */
+#else
   labelLookup_t exitLUT; /* Table from vertex label -> express vertex */
   int exitLUTNum;        /* Number of filled LUT entries */
+#endif
 } *eGraph_t;
 
 /***************************************************************/
-typedef struct pArc_s {
-  int idx;
-  int head;
-  struct pArc_s *next;
-} *pArc_t;
-
-typedef struct pArcFlat_s {
-  int idx;
-  int head;
-} *pArcFlat_t;
+/* Express arcs added to one entrance during a merge, kept as an
+   open-addressed set of head labels */
+typedef struct pArcSet_s {
+  int  num;              /* Number of head labels in the set */
+  int  size;             /* Number of slots (power of 2), 0 if unallocated */
+  int *slot;             /* Head label in each slot, -1 if empty */
+} *pArcSet_t;
+
+/* Lookup tables built over a packed express graph for one merge */
+typedef struct pegIndex_s {
+  int  labelSize;        /* Size of the exit label hash table (power of 2) */
+  int  labelNum;         /* Number of labels in the table */
+  int *labelKey;         /* Exit label held in each slot, -1 if empty */
+  int *labelExit;        /* First exit index with this label, -1 if none */
+  int *labelPred;        /* First pred record for this label, -1 if none */
+  int *labelLive;        /* Number of live exits with this label */
+  int *exitNext;         /* Next exit index with the same label, -1 if none */
+  int  entrSize;         /* Size of the (label, adj) entrance hash table */
+  int *entrSlot;         /* Entrance index held in each slot, -1 if empty */
+  int  predNum;          /* Number of pred records in use */
+  int  predMax;          /* Number of pred records allocated */
+  int *predEntr;         /* Entrance with an express arc to the label */
+  int *predNext;         /* Next pred record for the same label, -1 if none */
+} *pegIndex_t;
+
+/* Order in which one merge stage eliminates its exits: a binary heap
+   keyed on the fill an elimination would create */
+typedef struct elimOrder_s {
+  int     num;           /* Number of exits still in the heap */
+  int     next;          /* Next exit index when not ordering */
+  double *key;           /* Estimated fill (preds x succs) of each entry */
+  int    *exitIdx;       /* Exit index of each entry */
+} *elimOrder_t;
+
+/* Fixed exchange pattern of the SCC engine: each exit sends one value
+   along its trans arc to the entrance at the other end, and can get one
+   back.  Positions never change, so only values travel after setup. */
+typedef struct sccPlan_s {
+  int  sendNum;          /* Number of exits, in send order */
+  int *sendExit;         /* Exit index at each send position */
+  int *sendCnt;          /* Values sent to each node */
+  int *sendOff;          /* Offset of each node's values */
+  int  recvNum;          /* Number of values received */
+  int *recvEntr;         /* Entrance index at each receive position, -1 if none */
+  int *recvCnt;          /* Values received from each node */
+  int *recvOff;          /* Offset of each node's values */
+} *sccPlan_t;
+
+/* One node's state in the peeling engine */
+typedef struct peelState_s {
+  int   num;             /* Number of local vertices */
+  int  *indeg;           /* Unpeeled preds of each local vertex */
+  int  *queue;           /* Local vertices ready to be peeled */
+  int   qNum;            /* Number of vertices in the queue */
+  int   peeled;          /* Number of local vertices peeled */
+  int **buf;             /* Decrements (head labels) waiting for each node */
+  int  *bufNum;          /* Number of decrements waiting for each node */
+  int  *bufMax;          /* Size of each node's buffer */
+  int   reqNum;          /* Number of sends not yet matched */
+  int   reqMax;          /* Size of req and reqBuf */
+  MPI_Request *req;      /* Outstanding sends */
+  int **reqBuf;          /* Buffer held by each outstanding send */
+} *peelState_t;
 
 typedef struct pExpGraph_s {
   int entrNum;           /* Number of entrance vertices */
@@ -111,7 +169,9 @@ typedef struct pExpGraph_s {
   int arcNum;            /* Number of express arcs */
   int *data;             /* Data of packed express graph */
   /********************************************************/
-  struct pArc_s *newArcs; /* Additional express arcs to merge in */
+  int *arcOffset;        /* Offset into data of each entrV's express arcs */
+  struct pegIndex_s *index; /* Lookup tables, only present during a merge */
+  struct pArcSet_s *newArcs; /* Additional express arcs to merge in, per entrV */
   int deadEntr;
   int deadExit;
   int deadArc;
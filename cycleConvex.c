@@ -140,12 +140,16 @@ static char rcsid[] = "$Id: cycleConvex.c,v 1.6 1999/07/11 15:42:13 dbader Exp $
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 #include "mpi.h"
 #include "misc.h"
 #include "cycleConvex.h"
 #include "queue.h"
 #include "mpi-printf.h"
 #include "timing.h"
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
 
 #define N_DEFAULT  (1<<10)
 #define MAXARCS     4
@@ -153,8 +157,46 @@ static char rcsid[] = "$Id: cycleConvex.c,v 1.6 1999/07/11 15:42:13 dbader Exp $
 
 #define PRINT_MERGESIZE 0
 
+/* Fan-in of the merge tree: a stage merges up to 2^MERGE_FANIN_LOG packs
+   on one rank and eliminates every exit internal to that group at once.
+   The fan-in drops, down to 2, while that many copies of the largest
+   current pack would exceed MERGE_FANIN_MAXBYTES */
+#define MERGE_FANIN_LOG      2
+#define MERGE_FANIN_MAXBYTES (256*1024*1024)
+
+/* Lay out the merge tree by greedy heavy-edge matching on the number of
+   trans arcs between ranks (see Merge_Plan), so ranks sharing the most
+   boundary merge first; 0 pairs ranks by their bits.  Only rank pairs
+   that share trans arcs are gathered, so planning costs O(E log E) for
+   E such pairs, not O(NODES^2) */
+#define MERGE_HEAVYEDGE 1
+
+/* Send a pack as one message, its size header in front of the data; the
+   receiver sizes it with MPI_Mprobe.  0 sends the header and the data as
+   two messages */
+#define PACK_ONEMSG 1
+
+/* With USE_OPENMP, an elimination that would test at least
+   OMP_MERGE_MINWORK new intervals spreads its entr0s over the threads */
+#define OMP_MERGE_MINWORK 4096
+
 #define USE_PEG 0
 
+/* Build the packed interval graph directly from the reach lists instead
+   of going through the linked eGraph_t */
+#define DIRECT_PACK 1
+
+/* Drop entrances whose intervals hold no live exit label and exits that
+   no live entrance's intervals hold, after building the pack and after
+   each merge */
+#define PRUNE_DEADENDS 1
+
+/* Restrict the input to the label windows spanned by back arcs before
+   Discovery, and skip the merge when there are none (see
+   Backarc_Restrict) */
+#define BACKARC_PRUNE 1
+#define BACKARC_GATHERMAX (1<<16)
+
 /*********************************************************/
 #define INPUT_LATTICE     0
 #define INPUT_LINEAR      1
@@ -194,6 +236,8 @@ int (*localIndex_func[])() = {
 BOOL CYCLE_FOUND;
 
 int MYNODE, NODES;
+int MERGENODE;    /* Position of this rank in the merge tree */
+int *mergeRank;   /* Rank at each merge tree position, -1 if none */
 FILE *outfile;
 FILE *errfile;
 
@@ -201,6 +245,7 @@ char *INPUT_GRAPH_NAME;
 
 #define MPI_TAG_SIZES   0
 #define MPI_TAG_DATA    1
+#define MPI_TAG_PACK    2
 
 #define ENTRV           0
 #define EXITV           1
@@ -229,18 +274,38 @@ static int transArcCompareHead(const void *a, const void *b) {
   return (((transArc_t *)a)->headAssn - ((transArc_t *)b)->headAssn);
 }
 
+#if MERGE_HEAVYEDGE
+static int pairCompareWeight(const void *a, const void *b) {
+  /* (weight, i, j) records: heaviest first, then by i and j */
+  const int *x = (const int *)a;
+  const int *y = (const int *)b;
+  if (x[0] != y[0])
+    return ((x[0] > y[0]) ? -1 : 1);
+  if (x[1] != y[1])
+    return (x[1] - y[1]);
+  return (x[2] - y[2]);
+}
+
+static int pairCompareEnds(const void *a, const void *b) {
+  /* (weight, i, j) records: by i and j */
+  const int *x = (const int *)a;
+  const int *y = (const int *)b;
+  if (x[1] != y[1])
+    return (x[1] - y[1]);
+  return (x[2] - y[2]);
+}
+#endif
+
+#if ENTR_LUT || !EXIT_DIRECT
 static int expGraphLabelCompare(const void *a, const void *b) {
   return (((labelLookup_t)a)->label - ((labelLookup_t)b)->label);
 }
+#endif
 
 static int pArcFlatCompare(const void *a, const void *b) {
   return (((pArcFlat_t)a)->idx - ((pArcFlat_t)b)->idx);
 }
 
-static int pIntervalFlatCompare(const void *a, const void *b) {
-  return (((pIntervalFlat_t)a)->idx - ((pIntervalFlat_t)b)->idx);
-}
-
 void Create_Input0(int n, vertexList_t *verts) {
   int num;
   int offset;
@@ -296,6 +361,8 @@ void Create_Input0(int n, vertexList_t *verts) {
 
   (*verts)->R = (reachlist_t)SAFE_MALLOC(num*sizeof(struct reachlist_s),
 					 "(cycle.c) (*verts)->R");
+  for (i=0 ; i<num ; i++)
+    ((*verts)->R + i)->next = (reachlist_t)NULL;
   
   return;
 }
@@ -402,6 +469,8 @@ void Create_Input_Lattice_Orig(int n, vertexList_t *verts) {
 
   (*verts)->R = (reachlist_t)SAFE_MALLOC(num*sizeof(struct reachlist_s),
 					 "(cycle.c) (*verts)->R");
+  for (i=0 ; i<num ; i++)
+    ((*verts)->R + i)->next = (reachlist_t)NULL;
   
   return;
 }
@@ -560,6 +629,8 @@ void Create_Input_Lattice(int n, vertexList_t *verts) {
 
   (*verts)->R = (reachlist_t)SAFE_MALLOC(num*sizeof(struct reachlist_s),
 					 "(cycle.c) (*verts)->R");
+  for (i=0 ; i<num ; i++)
+    ((*verts)->R + i)->next = (reachlist_t)NULL;
   
   return;
 }
@@ -626,6 +697,8 @@ void Create_Input_Linear(int n, vertexList_t *verts) {
 
   (*verts)->R = (reachlist_t)SAFE_MALLOC(num*sizeof(struct reachlist_s),
 					 "(cycle.c) (*verts)->R");
+  for (i=0 ; i<num ; i++)
+    ((*verts)->R + i)->next = (reachlist_t)NULL;
   
   return;
 }
@@ -677,6 +750,8 @@ void Create_Input_LocalCycles(int n, vertexList_t *verts) {
 
   (*verts)->R = (reachlist_t)SAFE_MALLOC(num*sizeof(struct reachlist_s),
 					 "(cycle.c) (*verts)->R");
+  for (i=0 ; i<num ; i++)
+    ((*verts)->R + i)->next = (reachlist_t)NULL;
   
   return;
 }
@@ -860,6 +935,136 @@ void visitLocal(vertexList_t verts, int vidx) {
   return;
 }
 
+/*************************************************************************/
+/* Back-arc windows.  An arc (u, v) with label(v) <= label(u) is a back  */
+/* arc, and every other arc climbs in label.  Going around a cycle the   */
+/* labels only fall along its back arcs, so each label on the cycle lies */
+/* in [label(v), label(u)] of one of them.  Arcs touching a vertex       */
+/* outside the union of these windows cannot be on a cycle.              */
+/*************************************************************************/
+
+BOOL Backarc_InWindow(int *win, int winNum, int x) {
+  /* win holds winNum sorted, disjoint [C0, C1] pairs */
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = winNum;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (win[2*mid] <= x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return ((lo > 0) && (x <= win[2*(lo-1)+1]));
+}
+
+int Backarc_Restrict(vertexList_t verts) {
+  /* Drop every arc that cannot lie on a cycle and return the global
+     number of back arcs; with none the graph is acyclic */
+  int i, j, k, myNum, total, winNum;
+  int *myWin, *win, *cnt, *offset;
+  int bound[2], gbound[2];
+  vertex_t v;
+
+  myNum = 0;
+  for (i=0 ; i<verts->num ; i++) {
+    v = verts->vlist + i;
+    for (j=0 ; j<v->arcs ; j++)
+      if (v->alist[j].head <= v->label)
+	myNum++;
+  }
+
+  MPI_Allreduce(&myNum, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  myWin = (int *)SAFE_MALLOC((2*myNum+2)*sizeof(int), "(cycleConvex.c) myWin");
+  k = 0;
+  bound[0] = INT_MAX;
+  bound[1] = INT_MAX;
+  for (i=0 ; i<verts->num ; i++) {
+    v = verts->vlist + i;
+    for (j=0 ; j<v->arcs ; j++) {
+      if (v->alist[j].head <= v->label) {
+	myWin[k++] = v->alist[j].head;
+	myWin[k++] = v->label;
+	if (v->alist[j].head < bound[0])
+	  bound[0] = v->alist[j].head;
+	if (-v->label < bound[1])
+	  bound[1] = -v->label;
+      }
+    }
+  }
+
+  if (total <= BACKARC_GATHERMAX) {
+    /* Few enough to give every node every window */
+    cnt    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleConvex.c) cnt");
+    offset = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleConvex.c) offset");
+    k = 2*myNum;
+    MPI_Allgather(&k, 1, MPI_INT, cnt, 1, MPI_INT, MPI_COMM_WORLD);
+    offset[0] = 0;
+    for (i=1 ; i<NODES ; i++)
+      offset[i] = offset[i-1] + cnt[i-1];
+    win = (int *)SAFE_MALLOC((2*total+2)*sizeof(int), "(cycleConvex.c) win");
+    MPI_Allgatherv(myWin, 2*myNum, MPI_INT,
+		   win, cnt, offset, MPI_INT, MPI_COMM_WORLD);
+    free(offset);
+    free(cnt);
+
+    /* Sort on C0 and coalesce overlapping windows */
+    qsort(win, total, 2*sizeof(int), intCompare);
+    winNum = 0;
+    for (i=0 ; i<total ; i++) {
+      if ((winNum > 0) && (win[2*i] <= win[2*(winNum-1)+1])) {
+	if (win[2*i+1] > win[2*(winNum-1)+1])
+	  win[2*(winNum-1)+1] = win[2*i+1];
+      }
+      else {
+	win[2*winNum]   = win[2*i];
+	win[2*winNum+1] = win[2*i+1];
+	winNum++;
+      }
+    }
+  }
+  else {
+    /* Otherwise one window from the lowest head to the highest tail;
+       the tail is negated so a single MIN reduction finds both */
+    MPI_Allreduce(bound, gbound, 2, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    win = (int *)SAFE_MALLOC(2*sizeof(int), "(cycleConvex.c) win");
+    win[0] = gbound[0];
+    win[1] = -gbound[1];
+    winNum = 1;
+  }
+  free(myWin);
+
+  k = 0;
+  for (i=0 ; i<verts->num ; i++) {
+    v = verts->vlist + i;
+    if (!Backarc_InWindow(win, winNum, v->label)) {
+      k += v->arcs;
+      v->arcs = 0;
+      continue;
+    }
+    myNum = 0;
+    for (j=0 ; j<v->arcs ; j++)
+      if (Backarc_InWindow(win, winNum, v->alist[j].head))
+	v->alist[myNum++] = v->alist[j];
+    k += v->arcs - myNum;
+    v->arcs = myNum;
+  }
+  free(win);
+
+#ifdef DEBUG_PRINT
+  fprintf(outfile,"PE%3d: back arcs: %d windows: %d arcs dropped: %d\n",
+	  MYNODE, total, winNum, k);
+#endif
+#if PRINT_MERGESIZE
+  if (MYNODE==0)
+    fprintf(outfile,"PE%3d: Back arcs: %d\n",MYNODE,total);
+#endif
+
+  return (total);
+}
+
 void Find_Local_Cycles(vertexList_t verts) {
   int i;
   int num;
@@ -1189,13 +1394,16 @@ void AddExitVertex(eGraph_t expGraph, transArc_t *tarc) {
   expGraph->exitV        = exitVertex;
   expGraph->exitNum++;
   
+#if !EXIT_DIRECT
   (expGraph->exitLUT + expGraph->exitLUTNum)->label = exitVertex->transArc->tail;
   (expGraph->exitLUT + expGraph->exitLUTNum)->expVertex = exitVertex;
   expGraph->exitLUTNum++;
+#endif
   
   return;
 }
 
+#if ENTR_LUT || !EXIT_DIRECT
 int binSearchLUT(labelLookup_t lut, int minIdx, int maxIdx, int target) {
   /* Search searchList recursively using binary search to find target.
      Return -1 if it does not exist, or target's index if it does. */
@@ -1211,6 +1419,7 @@ int binSearchLUT(labelLookup_t lut, int minIdx, int maxIdx, int target) {
   else
     return midIdx;
 }
+#endif
 
 #if ENTR_LUT
 expVertex_t getEntrVertexLUT(eGraph_t expGraph, int label) {
@@ -1227,6 +1436,7 @@ expVertex_t getEntrVertexLUT(eGraph_t expGraph, int label) {
 }
 #endif
 
+#if !EXIT_DIRECT
 expVertex_t getExitVertexLUT(eGraph_t expGraph, int label) {
   int idx;
   expVertex_t v;
@@ -1239,6 +1449,15 @@ expVertex_t getExitVertexLUT(eGraph_t expGraph, int label) {
   
   return v;
 }
+#endif
+
+#if EXIT_DIRECT
+expVertex_t getExitVertexDirect(vertexList_t verts, eGraph_t expGraph,
+				int label) {
+  /* Exit vertices are local, so their label maps to a dense local index */
+  return (expGraph->exitDirect[localIndex(verts, label)]);
+}
+#endif
 
 reachlist_t getReachList(vertexList_t verts, int label) {
   int idx;
@@ -1283,7 +1502,11 @@ void AddExpressArcSet(vertexList_t verts, eGraph_t expGraph,
   while (rlist != (reachlist_t)NULL) {
     reachLabelIdx = rlist->idx;
     reachLabel    = globalLabel(verts, reachLabelIdx);
+#if EXIT_DIRECT
+    exitVertex    = getExitVertexDirect(verts, expGraph, reachLabel);
+#else
     exitVertex    = getExitVertexLUT(expGraph, reachLabel);
+#endif
     if (exitVertex == (expVertex_t)NULL)
       fprintf(errfile,"PE%3d: ERROR: getExitVertexLUT returned NULL\n", MYNODE);
     
@@ -1300,8 +1523,10 @@ void SortExpGraphLUT(eGraph_t expGraph) {
   qsort(expGraph->entrLUT, expGraph->entrLUTNum, sizeof(struct labelLookup_s),
 	expGraphLabelCompare);
 #endif
+#if !EXIT_DIRECT
   qsort(expGraph->exitLUT, expGraph->exitLUTNum, sizeof(struct labelLookup_s),
 	expGraphLabelCompare);
+#endif
   return;
 }
 
@@ -1333,18 +1558,32 @@ void Create_Express(vertexList_t verts,
   (*expGraph)->entrLUTNum  = 0;
 #endif
   
+#if !EXIT_DIRECT
   (*expGraph)->exitLUT = (labelLookup_t)
     SAFE_MALLOC(initTransArcCount * sizeof(struct labelLookup_s),
 		"(cycle.c) (*expGraph)->exitLUT");
   (*expGraph)->exitLUTNum  = 0;
+#else
+  (*expGraph)->exitDirect = (expVertex_t *)
+    SAFE_MALLOC(verts->num * sizeof(expVertex_t),
+		"(cycleConvex.c) (*expGraph)->exitDirect");
+  for (i=0 ; i<verts->num ; i++)
+    (*expGraph)->exitDirect[i] = (expVertex_t)NULL;
+#endif
 
   for (i=0 ; i<initTransArcCount ; i++) {
     AddExitVertex(*expGraph, initTransArcs+i);
+#if EXIT_DIRECT
+    (*expGraph)->exitDirect[localIndex(verts, initTransArcs[i].tail)] =
+      (*expGraph)->exitV;
+#endif
   }
 
+#if !EXIT_DIRECT
   if ((*expGraph)->exitLUTNum != initTransArcCount)
     fprintf(errfile,"PE%3d: ERROR: exitLUTNum (%d) != initTransArcCount (%d)\n",
 	    MYNODE, (*expGraph)->exitLUTNum, initTransArcCount);
+#endif
 
   for (i=0 ; i<termTransArcCount ; i++) {
     AddEntrVertex(*expGraph, termTransArcs+i);
@@ -1401,7 +1640,11 @@ void Free_expVertex(expVertex_t v) {
 void Free_Express(eGraph_t expGraph) {
   expVertex_t v, nextv;
 
+#if EXIT_DIRECT
+  free(expGraph->exitDirect);
+#else
   free(expGraph->exitLUT);
+#endif
 #if ENTR_LUT
   free(expGraph->entrLUT);
 #endif
@@ -1679,11 +1922,9 @@ int peg_GetEntrIdx(pExpGraph_t peg, int label, int adj) {
   return (-1);
 }
 
-void peg_Init(pExpGraph_t peg) {
+void peg_InitAux(pExpGraph_t peg) {
+  /* Everything peg_Init sets up but the data itself */
   int i;
-  
-  peg->data    = (int *)SAFE_MALLOC(peg_GetDataInBytes(peg),
-				    "(cycle.c) peg->data");
 
   peg->newArcs  = (pArc_t)NULL;
   peg->deadEntr = 0;
@@ -1704,6 +1945,13 @@ void peg_Init(pExpGraph_t peg) {
   return;
 }
 
+void peg_Init(pExpGraph_t peg) {
+  peg->data    = (int *)SAFE_MALLOC(peg_GetDataInBytes(peg),
+				    "(cycle.c) peg->data");
+  peg_InitAux(peg);
+  return;
+}
+
 void peg_SortArcs(pExpGraph_t peg, int idx, BOOL vType) {
   
   switch (vType) {
@@ -1833,16 +2081,40 @@ void Free_ExpressPack(pExpGraph_t peg) {
   return;
 }
 
+MPI_Datatype Pack_MsgType(int *sizeBuf, int *data, int dataInts) {
+  /* The 3-int size header and the data of a pack, as one message */
+  MPI_Datatype msgType;
+  int          len[2];
+  MPI_Aint     disp[2];
+
+  len[0] = 3;
+  len[1] = dataInts;
+  MPI_Get_address(sizeBuf, disp);
+  MPI_Get_address(data, disp + 1);
+  MPI_Type_create_hindexed(2, len, disp, MPI_INT, &msgType);
+  MPI_Type_commit(&msgType);
+  return (msgType);
+}
+
 void Send_ExpressPack(pExpGraph_t peg, int toNode) {
   int sizeBuf[3];
+#if PACK_ONEMSG
+  MPI_Datatype msgType;
+#endif
 
   sizeBuf[0] = peg->entrNum;
   sizeBuf[1] = peg->exitNum;
   sizeBuf[2] = peg->arcNum;
 
+#if PACK_ONEMSG
+  msgType = Pack_MsgType(sizeBuf, peg->data, peg_GetDataInInts(peg));
+  MPI_Send(MPI_BOTTOM, 1, msgType, toNode, MPI_TAG_PACK, MPI_COMM_WORLD);
+  MPI_Type_free(&msgType);
+#else
   MPI_Send(sizeBuf, 3, MPI_INT, toNode, MPI_TAG_SIZES, MPI_COMM_WORLD);
   MPI_Send(peg->data, peg_GetDataInInts(peg), MPI_INT, toNode, MPI_TAG_DATA,
 	   MPI_COMM_WORLD);
+#endif
   
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: I SENT THIS TO PE%3d\n",MYNODE,toNode);
@@ -1857,11 +2129,31 @@ void Recv_ExpressPack(pExpGraph_t *pExpGraph, int fromNode) {
   pExpGraph_t peg;
   int         sizeBuf[3];
   MPI_Status  mpstat;
+#if PACK_ONEMSG
+  MPI_Message  msg;
+  MPI_Datatype msgType;
+  int          count;
+#endif
   
   *pExpGraph = (pExpGraph_t)SAFE_MALLOC(sizeof(struct pExpGraph_s),
 					"(cycle.c) *pExpGraph");
   peg = *pExpGraph;
 
+#if PACK_ONEMSG
+  /* The message size gives the data size; the header comes with it */
+  MPI_Mprobe(fromNode, MPI_TAG_PACK, MPI_COMM_WORLD, &msg, &mpstat);
+  MPI_Get_count(&mpstat, MPI_INT, &count);
+  peg->data = (int *)SAFE_MALLOC((count-3)*sizeof(int),
+				 "(cycle.c) peg->data");
+  msgType = Pack_MsgType(sizeBuf, peg->data, count-3);
+  MPI_Mrecv(MPI_BOTTOM, 1, msgType, &msg, &mpstat);
+  MPI_Type_free(&msgType);
+
+  peg->entrNum = sizeBuf[0];
+  peg->exitNum = sizeBuf[1];
+  peg->arcNum  = sizeBuf[2];
+  peg_InitAux(peg);
+#else
   MPI_Recv(sizeBuf, 3, MPI_INT, fromNode, MPI_TAG_SIZES, MPI_COMM_WORLD,
 	   &mpstat);
 
@@ -1873,6 +2165,7 @@ void Recv_ExpressPack(pExpGraph_t *pExpGraph, int fromNode) {
   
   MPI_Recv(peg->data, peg_GetDataInInts(peg), MPI_INT, fromNode, MPI_TAG_DATA,
 	   MPI_COMM_WORLD, &mpstat);
+#endif
   
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: I RECEIVED THIS FROM PE%3d\n",MYNODE,fromNode);
@@ -2709,24 +3002,217 @@ void pig_SetIntervalC1(pIntervalGraph_t pig, int idxEntr, int intnum, int val) {
   return;
 }
 
-int pig_GetEntrIdx(pIntervalGraph_t pig, int label, int adj) {
+/*************************************************************************/
+/* Per-merge lookup tables:                                              */
+/*   label -> number of live exits with that label                       */
+/*   label -> intervals having that label as an endpoint                 */
+/* Removing the last exit with a label can only change intervals that    */
+/* end at it, so only those are visited.                                 */
+/*************************************************************************/
+
+#define PIG_HASH(x) ((unsigned int)(x) * 2654435761U)
+
+int pig_IndexTableSize(int n) {
+  /* Smallest power of two holding n keys at a load factor of 1/2 */
+  int size;
+  size = 2;
+  while (size < 2*n)
+    size <<= 1;
+  return size;
+}
+
+void pig_IndexGrowLabels(pigIndex_t ix) {
+  /* Double the label table and rehash it.  Endpoint records hang off
+     the slots by index, so they move along unchanged. */
+  unsigned int mask, h;
+  int i, oldSize, *oldKey, *oldLive, *oldRef;
+
+  oldSize = ix->labelSize;
+  oldKey  = ix->labelKey;
+  oldLive = ix->labelLive;
+  oldRef  = ix->labelRef;
+
+  ix->labelSize = 2*oldSize;
+  ix->labelKey  = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleConvex.c) ix->labelKey");
+  ix->labelLive = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleConvex.c) ix->labelLive");
+  ix->labelRef  = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleConvex.c) ix->labelRef");
+  for (i=0 ; i<ix->labelSize ; i++)
+    ix->labelKey[i] = -1;
+
+  mask = (unsigned int)ix->labelSize - 1;
+  for (i=0 ; i<oldSize ; i++)
+    if (oldKey[i] >= 0) {
+      h = PIG_HASH(oldKey[i]) & mask;
+      while (ix->labelKey[h] >= 0)
+	h = (h + 1) & mask;
+      ix->labelKey[h]  = oldKey[i];
+      ix->labelLive[h] = oldLive[i];
+      ix->labelRef[h]  = oldRef[i];
+    }
+
+  free(oldRef);
+  free(oldLive);
+  free(oldKey);
+  return;
+}
+
+int pig_IndexLabelSlot(pigIndex_t ix, int label, BOOL insert) {
+  /* Return the slot of label, inserting it if requested.
+     Returns -1 if the label is absent and not inserted.  An insert that
+     would take the table past half full grows it first, so a probe
+     always reaches an empty slot. */
+  unsigned int mask, h;
+  int probe;
+
+  mask = (unsigned int)ix->labelSize - 1;
+  h = PIG_HASH(label) & mask;
+  for (probe=0 ; ix->labelKey[h] >= 0 ; probe++) {
+    if (ix->labelKey[h] == label)
+      return (int)h;
+    if (probe == ix->labelSize) {
+      fprintf(errfile,"PE%3d: ERROR: label table full (%d slots)\n",
+	      MYNODE, ix->labelSize);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    h = (h + 1) & mask;
+  }
+  if (!insert)
+    return (-1);
+  if (2*(ix->labelNum+1) > ix->labelSize) {
+    pig_IndexGrowLabels(ix);
+    return (pig_IndexLabelSlot(ix, label, TRUE));
+  }
+  ix->labelKey[h]  = label;
+  ix->labelLive[h] = 0;
+  ix->labelRef[h]  = -1;
+  ix->labelNum++;
+  return (int)h;
+}
+
+void pig_IndexAddRef(pigIndex_t ix, int label, int entrIdx, int intnum) {
+  int slot, rec;
+
+  if (label < 0)
+    return;
+
+  if (ix->refNum == ix->refMax) {
+    ix->refMax  = 2*ix->refMax + 16;
+    ix->refEntr = (int *)realloc(ix->refEntr, ix->refMax*sizeof(int));
+    ix->refInt  = (int *)realloc(ix->refInt,  ix->refMax*sizeof(int));
+    ix->refNext = (int *)realloc(ix->refNext, ix->refMax*sizeof(int));
+    if ((ix->refEntr == (int *)NULL) || (ix->refInt == (int *)NULL) ||
+	(ix->refNext == (int *)NULL))
+      fprintf(errfile,"PE%3d: ERROR: realloc failed in pig_IndexAddRef\n",
+	      MYNODE);
+  }
+
+  slot = pig_IndexLabelSlot(ix, label, TRUE);
+  rec  = ix->refNum++;
+  ix->refEntr[rec]    = entrIdx;
+  ix->refInt[rec]     = intnum;
+  ix->refNext[rec]    = ix->labelRef[slot];
+  ix->labelRef[slot]  = rec;
+  return;
+}
+
+void pig_BuildIndex(pIntervalGraph_t pig) {
+  pigIndex_t ix;
+  int i, k, slot, intervals, C0, C1;
+
+  ix = (pigIndex_t)SAFE_MALLOC(sizeof(struct pigIndex_s),
+			       "(cycleConvex.c) pig->index");
+  pig->index = ix;
+
+  /* Room for the exit labels, both endpoints of every interval, and the
+     two endpoints each removed label can shift an interval to */
+  ix->labelSize = pig_IndexTableSize(3*pig->exitNum + 2*pig->intervalNum);
+  ix->labelKey  = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleConvex.c) ix->labelKey");
+  ix->labelLive = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleConvex.c) ix->labelLive");
+  ix->labelRef  = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleConvex.c) ix->labelRef");
+  for (i=0 ; i<ix->labelSize ; i++)
+    ix->labelKey[i] = -1;
+  ix->labelNum  = 0;
+
+  ix->refNum  = 0;
+  ix->refMax  = 2*pig->intervalNum + 16;
+  ix->refEntr  = (int *)SAFE_MALLOC(ix->refMax*sizeof(int),
+				    "(cycleConvex.c) ix->refEntr");
+  ix->refInt   = (int *)SAFE_MALLOC(ix->refMax*sizeof(int),
+				    "(cycleConvex.c) ix->refInt");
+  ix->refNext  = (int *)SAFE_MALLOC(ix->refMax*sizeof(int),
+				    "(cycleConvex.c) ix->refNext");
+
+  for (i=0 ; i<pig->exitNum ; i++)
+    if (pig->deadExitMask[i] == FALSE) {
+      /* The insert may grow the table, so take the slot first */
+      slot = pig_IndexLabelSlot(ix, pig_GetLabel(pig, i, EXITV), TRUE);
+      ix->labelLive[slot]++;
+    }
+
+  for (i=0 ; i<pig->entrNum ; i++) {
+    intervals = pig_GetIntervalCount(pig, i, ENTRV);
+    for (k=0 ; k<intervals ; k++) {
+      C0 = pig_GetIntervalC0(pig, i, k);
+      C1 = pig_GetIntervalC1(pig, i, k);
+      if (C1 < C0)
+	continue;
+      pig_IndexAddRef(ix, C0, i, k);
+      if (C1 != C0)
+	pig_IndexAddRef(ix, C1, i, k);
+    }
+  }
+
+  return;
+}
+
+void pig_FreeIndex(pIntervalGraph_t pig) {
+  pigIndex_t ix;
+
+  ix = pig->index;
+  if (ix == (pigIndex_t)NULL)
+    return;
+  free(ix->refNext);
+  free(ix->refInt);
+  free(ix->refEntr);
+  free(ix->labelRef);
+  free(ix->labelLive);
+  free(ix->labelKey);
+  free(ix);
+  pig->index = (pigIndex_t)NULL;
+  return;
+}
+
+int pig_FindEntrIdx(pIntervalGraph_t pig, int label, int adj) {
+  /* Index of the live entrance (label, adj), or -1 if there is none */
   int i;
   
   for (i=0 ; i<pig->entrNum ; i++) {
     if ((pig_GetLabel(pig, i, ENTRV) == label) &&
-	(pig_GetAdj(pig, i, ENTRV) == adj))
+	(pig_GetAdj(pig, i, ENTRV) == adj) &&
+	(pig->deadEntrMask[i] == FALSE))
       return(i);
   }
-
-  fprintf(errfile,"PE%3d: ERROR: pig_GetEntrIdx()\n",MYNODE);
   return (-1);
 }
 
-void pig_Init(pIntervalGraph_t pig) {
+int pig_GetEntrIdx(pIntervalGraph_t pig, int label, int adj) {
+  int i;
+
+  i = pig_FindEntrIdx(pig, label, adj);
+  if (i < 0)
+    fprintf(errfile,"PE%3d: ERROR: pig_GetEntrIdx()\n",MYNODE);
+  return (i);
+}
+
+void pig_InitAux(pIntervalGraph_t pig) {
+  /* Everything pig_Init sets up but the data itself */
   int i;
-  
-  pig->data    = (int *)SAFE_MALLOC(pig_GetDataInBytes(pig),
-				    "(cycle.c) pig->data");
 
   pig->deadEntr = 0;
   pig->deadExit = 0;
@@ -2743,12 +3229,172 @@ void pig_Init(pIntervalGraph_t pig) {
 
   pig->newInt = 0;
   pig->deadInt = 0;
-  pig->newIntervals = (pInterval_t)NULL;
+  pig->index = (pigIndex_t)NULL;
+  pig->newIntervals = (pIntervalSet_t)
+    SAFE_MALLOC((pig->entrNum+1) * sizeof(struct pIntervalSet_s),
+		"(cycleConvex.c) pig->newIntervals");
+  for (i=0 ; i<pig->entrNum ; i++) {
+    pig->newIntervals[i].num  = 0;
+    pig->newIntervals[i].size = 0;
+    pig->newIntervals[i].iv   = (int *)NULL;
+  }
   pig->intList = (int **)NULL;
   
   return;
 }
 
+void pig_Init(pIntervalGraph_t pig) {
+  pig->data    = (int *)SAFE_MALLOC(pig_GetDataInBytes(pig),
+				    "(cycle.c) pig->data");
+  pig_InitAux(pig);
+  return;
+}
+
+/*************************************************************************/
+/* Sorted, coalesced interval lists.  An entrance's intervals in data   */
+/* are kept sorted by C0 and disjoint; an interval emptied by vertex    */
+/* removal is left in place as [L, L-1] so the order is not disturbed.  */
+/* Intervals added during a merge go in a per-entrance pIntervalSet_t.  */
+/*************************************************************************/
+
+int pig_IntervalSearch(int *iv, int num, int target) {
+  /* Index of the last interval with C0 <= target, or -1 */
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = num - 1;
+  while (lo <= hi) {
+    mid = lo + (hi - lo) / 2;
+    if (iv[2*mid] <= target)
+      lo = mid + 1;
+    else
+      hi = mid - 1;
+  }
+  return (hi);
+}
+
+int pig_IntervalCoalesce(int *out, int *a, int na, int *b, int nb) {
+  /* Union of the sorted interval lists a and b, coalescing overlapping and
+     adjacent intervals and dropping empty ones.  Writes the result to out
+     (if not NULL) and returns the number of intervals. */
+  int i, j, n;
+  int C0, C1, curC0, curC1;
+  BOOL have;
+
+  i = j = n = 0;
+  have = FALSE;
+  curC0 = curC1 = 0;
+  while ((i < na) || (j < nb)) {
+    if ((j >= nb) || ((i < na) && (a[2*i] <= b[2*j]))) {
+      C0 = a[2*i];
+      C1 = a[2*i+1];
+      i++;
+    }
+    else {
+      C0 = b[2*j];
+      C1 = b[2*j+1];
+      j++;
+    }
+    if (C1 < C0)
+      continue;
+    if (have && (C0 <= curC1 + 1)) {
+      curC1 = max(curC1, C1);
+    }
+    else {
+      if (have) {
+	if (out != (int *)NULL) {
+	  out[2*n]   = curC0;
+	  out[2*n+1] = curC1;
+	}
+	n++;
+      }
+      curC0 = C0;
+      curC1 = C1;
+      have  = TRUE;
+    }
+  }
+  if (have) {
+    if (out != (int *)NULL) {
+      out[2*n]   = curC0;
+      out[2*n+1] = curC1;
+    }
+    n++;
+  }
+  return (n);
+}
+
+BOOL pig_IntervalSetFind(pIntervalSet_t set, int C0, int C1) {
+  /* Is [C0, C1] inside one interval of the set? */
+  int k;
+
+  k = pig_IntervalSearch(set->iv, set->num, C0);
+  return ((k >= 0) && (C1 <= set->iv[2*k+1]));
+}
+
+int pig_IntervalSetInsert(pIntervalSet_t set, int C0, int C1) {
+  /* Union [C0, C1] into the set, returning the change in its size */
+  int lo, hi, k, oldNum;
+
+  oldNum = set->num;
+
+  /* Intervals lo..hi-1 overlap or touch [C0, C1] */
+  lo = pig_IntervalSearch(set->iv, set->num, C0);
+  if ((lo < 0) || (set->iv[2*lo+1] + 1 < C0))
+    lo++;
+  hi = lo;
+  while ((hi < set->num) && (set->iv[2*hi] <= C1 + 1)) {
+    C0 = min(C0, set->iv[2*hi]);
+    C1 = max(C1, set->iv[2*hi+1]);
+    hi++;
+  }
+
+  if (hi == lo) {
+    /* Nothing to absorb; open a slot at lo */
+    if (set->num == set->size) {
+      set->size = (set->size == 0) ? 4 : 2*set->size;
+      set->iv = (int *)realloc(set->iv, 2*set->size*sizeof(int));
+      if (set->iv == (int *)NULL)
+	fprintf(errfile,"PE%3d: ERROR: realloc failed in pig_IntervalSetInsert\n",
+		MYNODE);
+    }
+    memmove(set->iv + 2*(lo+1), set->iv + 2*lo,
+	    2*(set->num - lo)*sizeof(int));
+    set->num++;
+  }
+  else {
+    /* Replace lo..hi-1 by the single union */
+    memmove(set->iv + 2*(lo+1), set->iv + 2*hi,
+	    2*(set->num - hi)*sizeof(int));
+    set->num -= hi - lo - 1;
+  }
+  set->iv[2*lo]   = C0;
+  set->iv[2*lo+1] = C1;
+
+  k = set->num - oldNum;
+  return (k);
+}
+
+void pig_IntervalSetClear(pIntervalSet_t set) {
+  if (set->iv != (int *)NULL)
+    free(set->iv);
+  set->num  = 0;
+  set->size = 0;
+  set->iv   = (int *)NULL;
+  return;
+}
+
+void pig_FreeIntervalSets(pIntervalGraph_t pig) {
+  int i;
+
+  if (pig->newIntervals == (pIntervalSet_t)NULL)
+    return;
+  for (i=0 ; i<pig->entrNum ; i++)
+    pig_IntervalSetClear(pig->newIntervals + i);
+  free(pig->newIntervals);
+  pig->newIntervals = (pIntervalSet_t)NULL;
+  return;
+}
+
 void pig_SortIntervals(pIntervalGraph_t pig, int idx, BOOL vType) {
   
   switch (vType) {
@@ -2766,6 +3412,74 @@ void pig_SortIntervals(pIntervalGraph_t pig, int idx, BOOL vType) {
   return;
 }
 
+/*************************************************************************/
+/* Exit records sorted by elimination stage; IntervalMerge at stage h    */
+/* walks only the leading run of stage-h exits                           */
+/*************************************************************************/
+
+int pig_ExitStage(pIntervalGraph_t pig, int idx, int h) {
+  /* Stage of exit idx; exits that are already internal count as stage h */
+  return (max(highB(MERGENODE ^ pig_GetAdjAssn(pig, idx, EXITV)), h));
+}
+
+void pig_SortExitsByStage(pIntervalGraph_t pig) {
+  /* Stable counting sort of a freshly built pack's exit records */
+  int count[8*sizeof(int)+1];
+  int *buf, *exitPtr;
+  int i, s, vs;
+
+  vs = pig_GetVSize();
+  exitPtr = pig->data + vs*pig->entrNum;
+  buf = (int *)SAFE_MALLOC(vs*pig->exitNum*sizeof(int) + 1,
+			   "(cycleConvex.c) buf");
+
+  for (s=0 ; s<=8*(int)sizeof(int) ; s++)
+    count[s] = 0;
+  for (i=0 ; i<pig->exitNum ; i++)
+    count[pig_ExitStage(pig, i, 0) + 1]++;
+  for (s=1 ; s<=8*(int)sizeof(int) ; s++)
+    count[s] += count[s-1];
+  for (i=0 ; i<pig->exitNum ; i++) {
+    s = pig_ExitStage(pig, i, 0);
+    memcpy(buf + vs*count[s], exitPtr + vs*i, vs*sizeof(int));
+    count[s]++;
+  }
+  memcpy(exitPtr, buf, vs*pig->exitNum*sizeof(int));
+
+  free(buf);
+  return;
+}
+
+int pig_MergeExits(pIntervalGraph_t pTemp, pIntervalGraph_t p0, pIntervalGraph_t p1, int h) {
+  /* Merge the stage-sorted exits of p0 and p1 into pTemp, whose entrance
+     count must already be set.  Returns the number of exits in stage h, which lead the list. */
+  int i0, i1, k, s0, s1, vs, stageNum;
+  int *dst;
+
+  vs  = pig_GetVSize();
+  dst = pTemp->data + vs*pTemp->entrNum;
+  i0 = i1 = k = 0;
+  stageNum = 0;
+  while ((i0 < p0->exitNum) || (i1 < p1->exitNum)) {
+    s0 = (i0 < p0->exitNum) ? pig_ExitStage(p0, i0, h) : -1;
+    s1 = (i1 < p1->exitNum) ? pig_ExitStage(p1, i1, h) : -1;
+    if ((s1 < 0) || ((s0 >= 0) && (s0 <= s1))) {
+      memcpy(dst + vs*k, p0->data + vs*(p0->entrNum + i0), vs*sizeof(int));
+      if (s0 == h)
+	stageNum++;
+      i0++;
+    }
+    else {
+      memcpy(dst + vs*k, p1->data + vs*(p1->entrNum + i1), vs*sizeof(int));
+      if (s1 == h)
+	stageNum++;
+      i1++;
+    }
+    k++;
+  }
+  return (stageNum);
+}
+
 void Create_IntervalPack(eGraph_t expGraph, pIntervalGraph_t *pIntervalGraph) {
   expVertex_t v;
   expArc_t a;
@@ -2779,12 +3493,20 @@ void Create_IntervalPack(eGraph_t expGraph, pIntervalGraph_t *pIntervalGraph) {
 
   pig->entrNum      = expGraph->entrNum;
   pig->exitNum      = expGraph->exitNum;
-  pig->intervalNum  = pig->entrNum;
+  pig->intervalNum  = 0;
+
+  /* Entrances that reach no exit get no interval */
+  for (v=expGraph->entrV ; v != (expVertex_t)NULL ; v=v->next)
+    if (v->expArcs != (expArc_t)NULL)
+      pig->intervalNum++;
 
   pig_Init(pig);
 
-  for (k=0 ; k<pig->entrNum ; k++)
-    pig_SetIntervalCount(pig, k, ENTRV, 1);
+  v = expGraph->entrV;
+  for (k=0 ; k<pig->entrNum ; k++) {
+    pig_SetIntervalCount(pig, k, ENTRV, (v->expArcs != (expArc_t)NULL)?1:0);
+    v = v->next;
+  }
 
   pig_SetIntervalOffsets(pig);
 
@@ -2828,6 +3550,81 @@ void Create_IntervalPack(eGraph_t expGraph, pIntervalGraph_t *pIntervalGraph) {
     k++;
     v = v->next;
   }
+  pig_SortExitsByStage(pig);
+
+  return;
+}
+
+void Create_IntervalPack_Direct(vertexList_t verts,
+				int initTransArcCount,
+				transArc_t *initTransArcs,
+				int termTransArcCount,
+				transArc_t *termTransArcs,
+				pIntervalGraph_t *pIntervalGraph)
+{
+  /* Build the packed interval graph straight from the reach lists.
+     Pass 1 sizes pig->data (one interval per entrance that reaches an
+     exit), and pass 2 fills in each entrance's [min, max] reach label.
+     Entrances that reach no exit get no interval. Vertices are stored
+     in the same (reverse) order as Create_IntervalPack. */
+  pIntervalGraph_t pig;
+  transArc_t *tarc;
+  reachlist_t rlist;
+  int k;
+  int val, minval, maxval;
+
+  *pIntervalGraph = (pIntervalGraph_t)SAFE_MALLOC(sizeof(struct pIntervalGraph_s),
+						  "(cycleConvex.c) *pIntervalGraph");
+  pig = *pIntervalGraph;
+
+  pig->entrNum      = termTransArcCount;
+  pig->exitNum      = initTransArcCount;
+  pig->intervalNum  = 0;
+
+  /* Pass 1: count */
+  for (k=0 ; k<termTransArcCount ; k++) {
+    if (getReachList(verts, termTransArcs[k].head)->next != (reachlist_t)NULL)
+      pig->intervalNum++;
+  }
+
+  pig_Init(pig);
+
+  /* Pass 2: fill */
+  for (k=0 ; k<pig->entrNum ; k++) {
+    tarc = termTransArcs + (termTransArcCount - 1 - k);
+    pig_SetLabel  (pig, k, ENTRV, tarc->head);
+    pig_SetAdj    (pig, k, ENTRV, tarc->tail);
+    pig_SetAdjAssn(pig, k, ENTRV, tarc->tailAssn);
+    rlist = getReachList(verts, tarc->head)->next;
+    pig_SetIntervalCount(pig, k, ENTRV, (rlist != (reachlist_t)NULL)?1:0);
+  }
+
+  pig_SetIntervalOffsets(pig);
+
+  for (k=0 ; k<pig->entrNum ; k++) {
+    if (pig_GetIntervalCount(pig, k, ENTRV) > 0) {
+      rlist = getReachList(verts, pig_GetLabel(pig, k, ENTRV))->next;
+      minval = maxval = globalLabel(verts, rlist->idx);
+      rlist = rlist->next;
+      while (rlist != (reachlist_t)NULL) {
+	val = globalLabel(verts, rlist->idx);
+	minval = min(minval, val);
+	maxval = max(maxval, val);
+	rlist = rlist->next;
+      }
+      pig_SetIntervalC0(pig, k, 0, minval);
+      pig_SetIntervalC1(pig, k, 0, maxval);
+    }
+  }
+
+  for (k=0 ; k<pig->exitNum ; k++) {
+    tarc = initTransArcs + (initTransArcCount - 1 - k);
+    pig_SetLabel  (pig, k, EXITV, tarc->tail);
+    pig_SetAdj    (pig, k, EXITV, tarc->head);
+    pig_SetAdjAssn(pig, k, EXITV, tarc->headAssn);
+    pig_SetIntervalCount(pig, k, EXITV, 0);
+  }
+  pig_SortExitsByStage(pig);
 
   return;
 }
@@ -2879,15 +3676,9 @@ void Print_IntervalPack(pIntervalGraph_t pig) {
 }
 
 void Free_IntervalPack(pIntervalGraph_t pig) {
-  pInterval_t i, nexti;
 
-  i = pig->newIntervals;
-  while (i != (pInterval_t)NULL) {
-    nexti = i->next;
-    free(i);
-    i = nexti;
-  }
-  
+  pig_FreeIntervalSets(pig);
+  pig_FreeIndex(pig);
   free(pig->deadEntrMask);
   free(pig->deadExitMask);
   if (pig->intList != (int **)NULL)
@@ -2900,14 +3691,23 @@ void Free_IntervalPack(pIntervalGraph_t pig) {
 
 void Send_IntervalPack(pIntervalGraph_t pig, int toNode) {
   int sizeBuf[3];
+#if PACK_ONEMSG
+  MPI_Datatype msgType;
+#endif
 
   sizeBuf[0] = pig->entrNum;
   sizeBuf[1] = pig->exitNum;
   sizeBuf[2] = pig->intervalNum;
 
+#if PACK_ONEMSG
+  msgType = Pack_MsgType(sizeBuf, pig->data, pig_GetDataInInts(pig));
+  MPI_Send(MPI_BOTTOM, 1, msgType, toNode, MPI_TAG_PACK, MPI_COMM_WORLD);
+  MPI_Type_free(&msgType);
+#else
   MPI_Send(sizeBuf, 3, MPI_INT, toNode, MPI_TAG_SIZES, MPI_COMM_WORLD);
   MPI_Send(pig->data, pig_GetDataInInts(pig), MPI_INT, toNode, MPI_TAG_DATA,
 	   MPI_COMM_WORLD);
+#endif
   
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: I SENT THIS TO PE%3d\n",MYNODE,toNode);
@@ -2922,11 +3722,31 @@ void Recv_IntervalPack(pIntervalGraph_t *pIntervalGraph, int fromNode) {
   pIntervalGraph_t pig;
   int         sizeBuf[3];
   MPI_Status  mpstat;
+#if PACK_ONEMSG
+  MPI_Message  msg;
+  MPI_Datatype msgType;
+  int          count;
+#endif
   
   *pIntervalGraph = (pIntervalGraph_t)SAFE_MALLOC(sizeof(struct pIntervalGraph_s),
 						  "(cycle.c) *pIntervalGraph");
   pig = *pIntervalGraph;
 
+#if PACK_ONEMSG
+  /* The message size gives the data size; the header comes with it */
+  MPI_Mprobe(fromNode, MPI_TAG_PACK, MPI_COMM_WORLD, &msg, &mpstat);
+  MPI_Get_count(&mpstat, MPI_INT, &count);
+  pig->data = (int *)SAFE_MALLOC((count-3)*sizeof(int),
+				 "(cycle.c) pig->data");
+  msgType = Pack_MsgType(sizeBuf, pig->data, count-3);
+  MPI_Mrecv(MPI_BOTTOM, 1, msgType, &msg, &mpstat);
+  MPI_Type_free(&msgType);
+
+  pig->entrNum      = sizeBuf[0];
+  pig->exitNum      = sizeBuf[1];
+  pig->intervalNum  = sizeBuf[2];
+  pig_InitAux(pig);
+#else
   MPI_Recv(sizeBuf, 3, MPI_INT, fromNode, MPI_TAG_SIZES, MPI_COMM_WORLD,
 	   &mpstat);
 
@@ -2938,6 +3758,7 @@ void Recv_IntervalPack(pIntervalGraph_t *pIntervalGraph, int fromNode) {
   
   MPI_Recv(pig->data, pig_GetDataInInts(pig), MPI_INT, fromNode, MPI_TAG_DATA,
 	   MPI_COMM_WORLD, &mpstat);
+#endif
 
   pig_SetIntervalOffsets(pig);
   
@@ -2950,26 +3771,71 @@ void Recv_IntervalPack(pIntervalGraph_t *pIntervalGraph, int fromNode) {
   return;
 }
 
+pIntervalGraph_t pig_ConcatPacks(pIntervalGraph_t *pList, int num) {
+  /* One compact pack holding the vertices and intervals of num compact
+     packs, with the exits re-sorted by stage.  Each entrance's intervals
+     are a block in entrance order, so the blocks concatenate as they are */
+  pIntervalGraph_t pig;
+  int *ptr;
+  int j, vs, is;
+
+  vs = pig_GetVSize();
+  is = pig_GetISize();
+
+  pig = (pIntervalGraph_t)SAFE_MALLOC(sizeof(struct pIntervalGraph_s),
+				      "(cycleConvex.c) pig");
+  pig->entrNum     = 0;
+  pig->exitNum     = 0;
+  pig->intervalNum = 0;
+  for (j=0 ; j<num ; j++) {
+    pig->entrNum     += pList[j]->entrNum;
+    pig->exitNum     += pList[j]->exitNum;
+    pig->intervalNum += pList[j]->intervalNum;
+  }
+
+  pig_Init(pig);
+
+  ptr = pig->data;
+  for (j=0 ; j<num ; j++) {
+    memcpy(ptr, pList[j]->data, vs*pList[j]->entrNum*sizeof(int));
+    ptr += vs*pList[j]->entrNum;
+  }
+  for (j=0 ; j<num ; j++) {
+    memcpy(ptr, pList[j]->data + vs*pList[j]->entrNum,
+	   vs*pList[j]->exitNum*sizeof(int));
+    ptr += vs*pList[j]->exitNum;
+  }
+  for (j=0 ; j<num ; j++) {
+    memcpy(ptr, pList[j]->data + vs*(pList[j]->entrNum + pList[j]->exitNum),
+	   is*pList[j]->intervalNum*sizeof(int));
+    ptr += is*pList[j]->intervalNum;
+  }
+
+  pig_SortExitsByStage(pig);
+  pig_SetIntervalOffsets(pig);
+  return (pig);
+}
+
 BOOL pig_CheckArcHead(pIntervalGraph_t pig, int idx, int target) {
-  int minval, maxval;
-  int intervals;
   int s;
-  BOOL found;
 
-  s = 0;
-  intervals = pig_GetIntervalCount(pig, idx, ENTRV);
-  found = FALSE;
-  while (!found && (s < intervals)) {
-    minval = pig_GetIntervalC0(pig, idx, s);
-    maxval = pig_GetIntervalC1(pig, idx, s);
-    found = ((minval <= target) && (target <= maxval));
-    s++;
-  }
-  
-  return(found);
+  s = pig_IntervalSearch(pig->intList[idx],
+			 pig_GetIntervalCount(pig, idx, ENTRV), target);
+  return ((s >= 0) && (target <= pig_GetIntervalC1(pig, idx, s)));
 }
 
 
+BOOL pig_CheckArc(pIntervalGraph_t pig, int idx, int arcHeadLabel) {
+  BOOL found;
+
+  found = pig_CheckArcHead(pig, idx, arcHeadLabel);
+  if (!found)
+    found = pig_IntervalSetFind(pig->newIntervals + idx,
+				arcHeadLabel, arcHeadLabel);
+
+  return (found);
+}
+
 void pig_GetEntrPred(pIntervalGraph_t pig, int label, int *num, int **listPred) {
   int i, n;
 
@@ -2978,7 +3844,7 @@ void pig_GetEntrPred(pIntervalGraph_t pig, int label, int *num, int **listPred)
 
   n=0;
   for (i=0 ; i<pig->entrNum ; i++) {
-    if (pig_CheckArcHead(pig, i, label)) {
+    if ((pig->deadEntrMask[i] == FALSE) && pig_CheckArc(pig, i, label)) {
       *(*listPred + n) = i; 
       n++;
     }
@@ -2992,42 +3858,16 @@ void pig_GetEntrPred(pIntervalGraph_t pig, int label, int *num, int **listPred)
   return;
 }
 
-BOOL pig_CheckArc(pIntervalGraph_t pig, int idx, int arcHeadLabel) {
-  pInterval_t pint;
-  BOOL found;
-
-  found = pig_CheckArcHead(pig, idx, arcHeadLabel);
-  
-  pint = pig->newIntervals;
-  while ((pint != (pInterval_t)NULL) && (!found)) {
-    found = ((pint->idx == idx) &&
-	     (pint->C0 <= arcHeadLabel) && (arcHeadLabel <= pint->C1));
-    pint = pint->next;
-  }
-
-  return (found);
-}
-
 BOOL pig_CheckInterval(pIntervalGraph_t pig, int idx, int C0, int C1) {
-  int s, intervals;
-  pInterval_t pint;
+  /* Is [C0, C1] already covered by one interval of entrance idx? */
+  int s;
   BOOL found;
 
-  intervals = pig_GetIntervalCount(pig, idx, ENTRV);
-  found = FALSE;
-  s = 0;
-  while ((!found) && (s<intervals)) {
-    found = ((pig_GetIntervalC0(pig, idx, s) == C0) &&
-	     (pig_GetIntervalC1(pig, idx, s) == C1));
-    s++;
-  }
-  
-  pint = pig->newIntervals;
-  while ((pint != (pInterval_t)NULL) && (!found)) {
-    found = ((pint->idx == idx) &&
-	     (pint->C0 == C0) && (pint->C1 == C1));
-    pint = pint->next;
-  }
+  s = pig_IntervalSearch(pig->intList[idx],
+			 pig_GetIntervalCount(pig, idx, ENTRV), C0);
+  found = ((s >= 0) && (C1 <= pig_GetIntervalC1(pig, idx, s)));
+  if (!found)
+    found = pig_IntervalSetFind(pig->newIntervals + idx, C0, C1);
 
   return (found);
 }
@@ -3035,6 +3875,8 @@ BOOL pig_CheckInterval(pIntervalGraph_t pig, int idx, int C0, int C1) {
 void pig_RemoveVertex(pIntervalGraph_t pig, int idx, BOOL vType) {
   int i, intervals, k, lab_exit;
   int minval, maxval;
+  int slot, rec;
+  pigIndex_t ix;
   BOOL found;
 #ifdef DEBUG_PRINT
   int lab_entr;
@@ -3051,6 +3893,9 @@ void pig_RemoveVertex(pIntervalGraph_t pig, int idx, BOOL vType) {
     pig->deadEntr++;
     pig->deadEntrMask[idx] = TRUE;
     pig->deadInt += pig_GetIntervalCount(pig, idx, vType);
+    /* Intervals added to a removed entrance are never merged in */
+    pig->newInt  -= pig->newIntervals[idx].num;
+    pig_IntervalSetClear(pig->newIntervals + idx);
 #ifdef DEBUG_PRINT
     fprintf(outfile,"PE%3d: Removing %s vertex \t killing %2d intervals\n",
 	    MYNODE, (vType==ENTRV)?"ENTR":"EXIT",
@@ -3066,6 +3911,51 @@ void pig_RemoveVertex(pIntervalGraph_t pig, int idx, BOOL vType) {
     /* If we are the last exit vertex with this label, remove Interval arcs
        aimed at us */
 
+    ix = pig->index;
+    if (ix != (pigIndex_t)NULL) {
+      /* Only intervals ending at our label can change; shrinking one
+	 makes it end at a neighbouring label, so record it there */
+      slot = pig_IndexLabelSlot(ix, lab_exit, FALSE);
+      if (slot < 0) {
+	fprintf(errfile,"PE%3d: ERROR: pig_RemoveVertex() label %d not indexed\n",
+		MYNODE, lab_exit);
+	break;
+      }
+      ix->labelLive[slot]--;
+      if (ix->labelLive[slot] > 0)
+	break;
+      rec = ix->labelRef[slot];
+      while (rec >= 0) {
+	i = ix->refEntr[rec];
+	k = ix->refInt[rec];
+	if (pig->deadEntrMask[i] == FALSE) {
+	  minval = pig_GetIntervalC0(pig, i, k);
+	  maxval = pig_GetIntervalC1(pig, i, k);
+	  if ((minval <= lab_exit) && (lab_exit <= maxval)) {
+	    if (minval == maxval) {
+	      /* Leave it empty, in place */
+	      pig_SetIntervalC1(pig, i, k, minval-1);
+	      pig->deadInt++;
+	    }
+	    else {
+	      if (minval == lab_exit) {
+		pig_SetIntervalC0(pig, i, k, minval+1);
+		pig_IndexAddRef(ix, minval+1, i, k);
+	      }
+	      else {
+		if (maxval == lab_exit) {
+		  pig_SetIntervalC1(pig, i, k, maxval-1);
+		  pig_IndexAddRef(ix, maxval-1, i, k);
+		}
+	      }
+	    }
+	  }
+	}
+	rec = ix->refNext[rec];
+      }
+      break;
+    }
+
     found = FALSE;
     i=0;
     while ((i<pig->exitNum) && (!found)) {
@@ -3089,9 +3979,8 @@ void pig_RemoveVertex(pIntervalGraph_t pig, int idx, BOOL vType) {
 	    maxval = pig_GetIntervalC1(pig, i, k);
 	    if ((minval <= lab_exit) && (lab_exit <= maxval)) {
 	      if (minval == maxval) {
-		/* Remove this interval */
-		pig_SetIntervalC0(pig, i, k, -1);
-		pig_SetIntervalC1(pig, i, k, -1);
+		/* Remove this interval, leaving it empty in place */
+		pig_SetIntervalC1(pig, i, k, minval-1);
 		pig->deadInt++;
 	      }
 	      else {
@@ -3115,229 +4004,315 @@ void pig_RemoveVertex(pIntervalGraph_t pig, int idx, BOOL vType) {
 }
 
 void pig_AddInterval(pIntervalGraph_t pig, int idx, int C0, int C1) {
-  pInterval_t pint;
 
-  pint = (pInterval_t)SAFE_MALLOC(sizeof(struct pInterval_s),
-				  "(cycle.c) pint");
+  pig->newInt += pig_IntervalSetInsert(pig->newIntervals + idx, C0, C1);
 
-  pint->idx  = idx;
-  pint->C0   = C0;
-  pint->C1   = C1;
-  pint->next = pig->newIntervals;
+  return;
+}
 
-  pig->newIntervals = pint;
-  pig->newInt++;
+#ifdef USE_OPENMP
+void pig_AddIntervalsOmp(pIntervalGraph_t pig, int *entr0List, int entr0Num,
+			 int entr1Idx) {
+  /* Give every entr0 the intervals of entr1 it does not already cover.
+     Each entr0's interval set is written by one thread only; entr1 is
+     never an entr0 here, or the cycle would have been caught. */
+  pIntervalSet_t entr1Set;
+  int p, s, num, minval, maxval, newInt;
+
+  entr1Set = pig->newIntervals + entr1Idx;
+  num = pig_GetIntervalCount(pig, entr1Idx, ENTRV);
+  newInt = 0;
+
+#pragma omp parallel for schedule(dynamic,16) private(s, minval, maxval) reduction(+:newInt)
+  for (p=0 ; p<entr0Num ; p++) {
+    for (s=0 ; s<num + entr1Set->num ; s++) {
+      if (s < num) {
+	minval = pig_GetIntervalC0(pig, entr1Idx, s);
+	maxval = pig_GetIntervalC1(pig, entr1Idx, s);
+      }
+      else {
+	minval = entr1Set->iv[2*(s-num)];
+	maxval = entr1Set->iv[2*(s-num)+1];
+      }
+      if (maxval < minval)
+	continue;
+      if (!pig_CheckInterval(pig, entr0List[p], minval, maxval))
+	newInt += pig_IntervalSetInsert(pig->newIntervals + entr0List[p],
+					minval, maxval);
+    }
+  }
 
+  pig->newInt += newInt;
   return;
 }
+#endif
 
 void pig_CleanUp(pIntervalGraph_t pig) {
-  /* Merge in the new Intervals and delete all vertices with marked labels */
-  pInterval_t iv, nextiv;
-  pIntervalFlat_t newIntsArr;
-  int k;
-  pIntervalGraph_t pigNew;
-  int intIdx, vIdx, i, nextIdx;
-  int totInt, curInt, newInt, idx0, j;
-  int iIdx, minlab;
-  int *intPtr, *intPtr0;
-
-  pigNew = (pIntervalGraph_t)SAFE_MALLOC(sizeof(struct pIntervalGraph_s),
-					 "(cycle.c) pigNew");
-  
-  pigNew->entrNum = pig->entrNum - pig->deadEntr;
-  pigNew->exitNum = pig->exitNum - pig->deadExit;
-  pigNew->intervalNum = pig->intervalNum - pig->deadInt + pig->newInt;
+  /* Merge in the new Intervals and delete all vertices with marked labels.
+     Each surviving entrance gets the coalesced union of its live intervals
+     and the ones added to it during the merge.  The pack is compacted in
+     place: live records slide down, an entrance with new intervals has its
+     union built in its interval set, the others are coalesced forward in
+     data, and then the blocks are laid out from the last entrance back. */
+  pIntervalSet_t set;
+  struct pIntervalSet_s tmpSet;
+  int i, k, vs, is;
+  int newEntr, newExit, newIntNum, oldInts, newInts;
+  int base, pos, end, num, *iv;
+
+  vs = pig_GetVSize();
+  is = pig_GetISize();
+  oldInts = pig_GetDataInInts(pig);
+
+  newEntr = 0;
+  for (i=0 ; i<pig->entrNum ; i++)
+    if (pig->deadEntrMask[i] == FALSE)
+      newEntr++;
+  newExit = 0;
+  for (i=0 ; i<pig->exitNum ; i++)
+    if (pig->deadExitMask[i] == FALSE)
+      newExit++;
+
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: dead entr: %3d dead exit: %3d dead int: %3d new int: %3d\n",
-	  MYNODE, pig->deadEntr, pig->deadExit, pig->deadInt, pig->newInt);
+	  MYNODE, pig->entrNum - newEntr, pig->exitNum - newExit,
+	  pig->deadInt, pig->newInt);
 #endif
 
-  pig_Init(pigNew);
-
-  newIntsArr = (pIntervalFlat_t)
-    SAFE_MALLOC(pig->newInt * sizeof(struct pIntervalFlat_s),
-		"(cycle.c) newIntsArr");
-
+  /* Entrance records, their interval sets and old interval pointers */
   k = 0;
-  iv = pig->newIntervals;
-  while (iv != (pInterval_t)NULL) {
-    newIntsArr[k].idx = iv->idx;
-    newIntsArr[k].C0  = iv->C0;
-    newIntsArr[k].C1  = iv->C1;
-    nextiv = iv->next;
-    free(iv);
-    iv = nextiv;
-    k++;
-  }
-
-  if (k != pig->newInt)
-    fprintf(errfile,"PE%3d: ERROR: k (%d) != pig->newInt (%d) \n",
-	    MYNODE, k, pig->newInt);
-
-  qsort(newIntsArr, k, sizeof(struct pIntervalFlat_s), pIntervalFlatCompare);
-
-#ifdef DEBUG_PRINT
-  for (i=0 ; i<k ; i++)
-    fprintf(outfile,"PE%3d: newIntsArr[%3d]: (%3d, [%3d %3d])\n",
-	    MYNODE, i, newIntsArr[i].idx, newIntsArr[i].C0, newIntsArr[i].C1);
-#endif
-  /* CHECK */
-
-  /* Entrance Vertices */
-  intIdx = 0;
-  vIdx = 0;
-  intPtr = pigNew->data + (pigNew->entrNum + pigNew->exitNum)*pig_GetVSize();
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu Entrance vertices (num %d)\n",MYNODE, pig->entrNum);
-#endif
   for (i=0 ; i<pig->entrNum ; i++) {
     if (pig->deadEntrMask[i] == FALSE) {
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu working on idx: %d (label: %d)\n",MYNODE,
-	  i, pig_GetLabel(pig, i, ENTRV));
-#endif
-      pig_SetLabel  (pigNew, vIdx, ENTRV, pig_GetLabel  (pig, i, ENTRV));
-      pig_SetAdj    (pigNew, vIdx, ENTRV, pig_GetAdj    (pig, i, ENTRV));
-      pig_SetAdjAssn(pigNew, vIdx, ENTRV, pig_GetAdjAssn(pig, i, ENTRV));
-
-      totInt = pig_GetIntervalCount(pig, i, ENTRV);
-
-      curInt = 0;
-      for (j=0 ; j<totInt ; j++) {
-	if (pig_GetIntervalC0(pig, i, j) >= 0)
-	  curInt++;
-      }
-      
-      idx0   = intIdx;
-      if (intIdx < k) {
-	nextIdx = newIntsArr[intIdx].idx;
-	if (nextIdx < i)
-	  fprintf(errfile,"PE%3d: ERROR: newInts[intIdx(%d)].idx (%d) < i (%d)\n",
-		  MYNODE, intIdx, newIntsArr[intIdx].idx, i);
-	while ((intIdx<k) && (nextIdx == i)) {
-	  intIdx++;
-	  if (intIdx<k)
-	    nextIdx =  newIntsArr[intIdx].idx;
-	}
-      }
-      newInt = intIdx - idx0;
-      pig_SetIntervalCount(pigNew, vIdx, ENTRV, curInt + newInt);
-      iIdx = 0;
-      intPtr0 = intPtr;
-      for (j=0 ; j<totInt ; j++) {
-	minlab = pig_GetIntervalC0(pig, i, j);
-	if (minlab >= 0) {
-	  *intPtr = minlab;
-	  intPtr++;
-	  *intPtr = pig_GetIntervalC1(pig, i, j);
-	  intPtr++;
-	  iIdx++;
-	}
-      }
-      if (iIdx != curInt)
-	fprintf(errfile,"PE%3d: ERROR: iIdx (%d) != curArc (%d)\n",
-		MYNODE, iIdx, curInt);
-      for (j=0 ; j<newInt ; j++) {
-	*intPtr = newIntsArr[idx0+j].C0;
-	intPtr++;
-	*intPtr = newIntsArr[idx0+j].C1;
-	intPtr++;
+      if (k != i) {
+	memmove(pig->data + k*vs, pig->data + i*vs, vs*sizeof(int));
+	tmpSet = pig->newIntervals[k];
+	pig->newIntervals[k] = pig->newIntervals[i];
+	pig->newIntervals[i] = tmpSet;
+	pig->intList[k] = pig->intList[i];
       }
-
-      if (curInt + newInt != (int)(intPtr - intPtr0) / 2)
-	fprintf(errfile,
-		"PE%3d: ERROR: intPtr (cur: %d new: %d [tot:%d]) (%p - %p = %d)\n",
-		MYNODE, curInt, newInt, curInt+newInt, intPtr, intPtr0,
-		(int)(intPtr - intPtr0)/2);
-
-      vIdx++;
+      k++;
     }
+    else
+      pig_IntervalSetClear(pig->newIntervals + i);
   }
 
-  if (vIdx != pigNew->entrNum)
-    fprintf(errfile,"PE%3d: ERROR: vIdx (%d) != pigNew->entrNum (%d)\n",
-	    MYNODE, vIdx, pigNew->entrNum);
-
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu entrance done\n",MYNODE);
-#endif
-
-  /* Exit Vertices */
-  vIdx   = 0;
-
+  /* Exit records */
+  k = 0;
   for (i=0 ; i<pig->exitNum ; i++) {
     if (pig->deadExitMask[i] == FALSE) {
-      pig_SetLabel  (pigNew, vIdx, EXITV, pig_GetLabel  (pig, i, EXITV));
-      pig_SetAdj    (pigNew, vIdx, EXITV, pig_GetAdj    (pig, i, EXITV));
-      pig_SetAdjAssn(pigNew, vIdx, EXITV, pig_GetAdjAssn(pig, i, EXITV));
-      pig_SetIntervalCount(pigNew, vIdx, EXITV,
-			   pig_GetIntervalCount(pig, i, EXITV));
-      vIdx++;
+      memmove(pig->data + (newEntr + k)*vs,
+	      pig->data + (pig->entrNum + i)*vs, vs*sizeof(int));
+      k++;
     }
   }
 
-  if (vIdx != pigNew->exitNum)
-    fprintf(errfile,"PE%3d: ERROR: vIdx (%d) != pigNew->exitNum (%d)\n",
-	    MYNODE, vIdx, pigNew->exitNum);
-  
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu exit done (num: %d) \n",MYNODE, pig->exitNum);
-#endif
+  /* Coalesce each entrance's intervals.  Without new intervals the
+     output never passes the input, so it is written forward in data. */
+  base = vs*(newEntr + newExit);
+  pos  = base;
+  newIntNum = 0;
+  for (k=0 ; k<newEntr ; k++) {
+    set = pig->newIntervals + k;
+    num = pig_GetIntervalCount(pig, k, ENTRV);
+    if (set->num > 0) {
+      i  = pig_IntervalCoalesce((int *)NULL, pig->intList[k], num,
+				set->iv, set->num);
+      iv = (int *)SAFE_MALLOC(is*i*sizeof(int), "(cycleConvex.c) iv");
+      pig_IntervalCoalesce(iv, pig->intList[k], num, set->iv, set->num);
+      free(set->iv);
+      set->iv   = iv;
+      set->num  = i;
+      set->size = i;
+      pig_SetIntervalCount(pig, k, ENTRV, 0);
+    }
+    else {
+      i = pig_IntervalCoalesce(pig->data + pos, pig->intList[k], num,
+			       (int *)NULL, 0);
+      pig_SetIntervalCount(pig, k, ENTRV, i);
+      pos += is*i;
+    }
+    newIntNum += i;
+  }
 
-  free(newIntsArr);
+  newInts = pig_GetDataInInts_Var(newEntr, newExit, newIntNum);
+  if (newInts > oldInts) {
+    pig->data = (int *)realloc(pig->data, newInts*sizeof(int));
+    if (pig->data == (int *)NULL)
+      fprintf(errfile,"PE%3d: ERROR: realloc failed in pig_CleanUp\n",
+	      MYNODE);
+  }
 
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu Freed newIntsArr\n",MYNODE);
-#endif
-  /* Swap in new data and parameters */
-  free(pig->data);
-  pig->entrNum  = pigNew->entrNum;
-  pig->exitNum  = pigNew->exitNum;
-  pig->intervalNum   = pigNew->intervalNum;
-  pig->data     = pigNew->data;
-#if 1
-  pigNew->data  = (int *)NULL;
-#endif
-  pig->newIntervals  = pigNew->newIntervals;
-  pig->deadEntr = pigNew->deadEntr;
-  pig->deadExit = pigNew->deadExit;
-  pig->deadInt  = pigNew->deadInt;
-  pig->newInt   = pigNew->newInt;
-  
-  pig->deadEntrMask = (BOOL *)SAFE_MALLOC(pig->entrNum * sizeof(BOOL),
-					  "(cycle.c) pig->deadEntrMask");
+  /* Final layout, last entrance first so no block overruns another */
+  end = base + is*newIntNum;
+  for (k=newEntr-1 ; k>=0 ; k--) {
+    set = pig->newIntervals + k;
+    if (set->num > 0) {
+      end -= is*set->num;
+      memcpy(pig->data + end, set->iv, is*set->num*sizeof(int));
+      pig_SetIntervalCount(pig, k, ENTRV, set->num);
+      pig_IntervalSetClear(set);
+    }
+    else {
+      num  = pig_GetIntervalCount(pig, k, ENTRV);
+      pos -= is*num;
+      end -= is*num;
+      if (end != pos)
+	memmove(pig->data + end, pig->data + pos, is*num*sizeof(int));
+    }
+  }
+  if ((end != base) || (pos != base))
+    fprintf(errfile,"PE%3d: ERROR: pig_CleanUp() interval base %d %d != %d\n",
+	    MYNODE, end, pos, base);
+
+  pig->entrNum     = newEntr;
+  pig->exitNum     = newExit;
+  pig->intervalNum = newIntNum;
+
+  if (newInts < oldInts) {
+    pig->data = (int *)realloc(pig->data, (newInts > 0 ? newInts : 1)*sizeof(int));
+    if (pig->data == (int *)NULL)
+      fprintf(errfile,"PE%3d: ERROR: realloc failed in pig_CleanUp\n",
+	      MYNODE);
+  }
+
+  /* The masks only shrink, so clear the live prefix and reuse them */
+  pig->deadEntr = 0;
+  pig->deadExit = 0;
+  pig->deadInt  = 0;
+  pig->newInt   = 0;
   for (i=0 ; i<pig->entrNum ; i++)
     *(pig->deadEntrMask + i) = FALSE;
-
-  pig->deadExitMask = (BOOL *)SAFE_MALLOC(pig->exitNum * sizeof(BOOL),
-					  "(cycle.c) pig->deadExitMask");
   for (i=0 ; i<pig->exitNum ; i++)
     *(pig->deadExitMask + i) = FALSE;
 
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu swapped data structure\n",MYNODE);
-#endif
-
   free(pig->intList);
   pig_SetIntervalOffsets(pig);
 
-  for (i=0 ; i<pig->entrNum ; i++)
-    pig_SortIntervals(pig, i, ENTRV);
-    
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: cu set new interval offsets\n",MYNODE);
 #endif
 
-  Free_IntervalPack(pigNew);
-  
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu Freed IntervalPack\n",MYNODE);
-#endif
+  return;
+}
+
+/*************************************************************************/
+/* Dead-end pruning.  Live exit labels are kept sorted so that each     */
+/* interval finds the exits it holds by binary search.  Each sweep      */
+/* drops the entrances that hold none and the exits that no live        */
+/* entrance holds; sweeps repeat until one removes nothing.  Exits are  */
+/* only marked: the labels they leave inside intervals have no exit in  */
+/* this pack, or in any pack merged into it later.                      */
+/*************************************************************************/
+
+int pig_LowerBound(int *a, int n, int key) {
+  /* First position in sorted a[0..n-1] holding a value >= key */
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = n;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (a[mid] < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return (lo);
+}
 
+void pig_RemoveOrphans(pIntervalGraph_t pig, int h) {
+  /* After stage h's eliminations, any live entrance whose paired exit
+     lies inside the merged group lost that exit to pruning */
+  int i;
+
+  for (i=0 ; i<pig->entrNum ; i++)
+    if ((pig->deadEntrMask[i] == FALSE) &&
+	(clearLastB(pig_GetAdjAssn(pig, i, ENTRV), h) == MERGENODE))
+      pig_RemoveVertex(pig, i, ENTRV);
   return;
 }
 
+int pig_Prune(pIntervalGraph_t pig) {
+  /* Remove dead-end vertices, returning the number removed */
+  pIntervalSet_t set;
+  int *labels, *reach;
+  int n, i, k, num, lo, hi, C0, C1, removed, swept;
+  BOOL live;
+
+  if (pig->intList == (int **)NULL)
+    pig_SetIntervalOffsets(pig);
+
+  labels = (int *)SAFE_MALLOC((pig->exitNum+1)*sizeof(int),
+			      "(cycleConvex.c) labels");
+  reach  = (int *)SAFE_MALLOC((pig->exitNum+1)*sizeof(int),
+			      "(cycleConvex.c) reach");
+  removed = 0;
+  do {
+    swept = 0;
+
+    n = 0;
+    for (i=0 ; i<pig->exitNum ; i++)
+      if (pig->deadExitMask[i] == FALSE)
+	labels[n++] = pig_GetLabel(pig, i, EXITV);
+    qsort(labels, n, sizeof(int), intCompare);
+    for (i=0 ; i<=n ; i++)
+      reach[i] = 0;
+
+    for (i=0 ; i<pig->entrNum ; i++) {
+      if (pig->deadEntrMask[i] == TRUE)
+	continue;
+      live = FALSE;
+      num  = pig_GetIntervalCount(pig, i, ENTRV);
+      set  = pig->newIntervals + i;
+      for (k=0 ; k<num+set->num ; k++) {
+	if (k < num) {
+	  C0 = pig_GetIntervalC0(pig, i, k);
+	  C1 = pig_GetIntervalC1(pig, i, k);
+	}
+	else {
+	  C0 = set->iv[2*(k-num)];
+	  C1 = set->iv[2*(k-num)+1];
+	}
+	if (C1 < C0)
+	  continue;
+	lo = pig_LowerBound(labels, n, C0);
+	hi = pig_LowerBound(labels, n, C1+1);
+	if (lo < hi) {
+	  /* Mark labels[lo..hi-1] as reached */
+	  reach[lo]++;
+	  reach[hi]--;
+	  live = TRUE;
+	}
+      }
+      if (!live) {
+	pig_RemoveVertex(pig, i, ENTRV);
+	swept++;
+      }
+    }
+
+    /* Prefix sums turn reach[] into the number of intervals holding
+       each label.  Intervals of entrances removed above held nothing. */
+    for (i=1 ; i<n ; i++)
+      reach[i] += reach[i-1];
+    for (i=0 ; i<pig->exitNum ; i++) {
+      if (pig->deadExitMask[i] == TRUE)
+	continue;
+      k = pig_LowerBound(labels, n, pig_GetLabel(pig, i, EXITV));
+      if (reach[k] == 0) {
+	pig->deadExit++;
+	pig->deadExitMask[i] = TRUE;
+	swept++;
+      }
+    }
+
+    removed += swept;
+  } while (swept > 0);
+
+  free(reach);
+  free(labels);
+  return (removed);
+}
+
 void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
   /* Merge p1 into p0 */
   pIntervalGraph_t pTemp;
@@ -3347,7 +4322,9 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
   int i;
   int curAdjAssn, origAdjAssn;
   int exit0, exit0Idx, entr1, entr1Idx;
+  int stageNum;
   int entr1IntervalNum;
+  pIntervalSet_t entr1Set;
   int p, s;
   int minval, maxval;
     
@@ -3384,15 +4361,11 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
   memcpy(ptr, loc1, siz*sizeof(int));
   ptr += siz;
 
-  siz   = p0->exitNum*pig_GetVSize();
+  /* Exits of this stage come first */
+  stageNum = pig_MergeExits(pTemp, p0, p1, h);
+  ptr  += (p0->exitNum + p1->exitNum)*pig_GetVSize();
   loc0 += p0->entrNum*pig_GetVSize();
-  memcpy(ptr, loc0 , siz*sizeof(int));
-  ptr += siz;
-
-  siz   = p1->exitNum*pig_GetVSize();
   loc1 += p1->entrNum*pig_GetVSize();
-  memcpy(ptr, loc1, siz*sizeof(int));
-  ptr += siz;
   
   siz   = p0->intervalNum*pig_GetISize();
   loc0 += p0->exitNum*pig_GetVSize();
@@ -3405,6 +4378,7 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
   ptr += siz;
 
   pig_SetIntervalOffsets(pTemp);
+  pig_BuildIndex(pTemp);
   
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: MY P0  MERGE\n",MYNODE);
@@ -3424,7 +4398,7 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
 
   /****** MERGE HERE ********/
 
-  for (i=0 ; i<pTemp->exitNum ; i++) {
+  for (i=0 ; i<stageNum ; i++) {
     exit0Idx = i;
     origAdjAssn = pig_GetAdjAssn(pTemp, exit0Idx, EXITV);
     curAdjAssn  = clearLastB(origAdjAssn, h);
@@ -3432,7 +4406,7 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
     fprintf(outfile,"PE%3d: h: %d orig: %d cur: %d\n",
 	    MYNODE, h, origAdjAssn, curAdjAssn);
 #endif
-    if (curAdjAssn == MYNODE) {
+    if (curAdjAssn == MERGENODE) {
       /* we have a winner */
 
       /* must locate the set of entrance vertices pointing to us,
@@ -3449,8 +4423,9 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
       /* entr1 = label of the entrance vertex we point to */
       entr1     = pig_GetAdj    (pTemp, exit0Idx, EXITV);
 
-      /* entr1Idx,ENTRV = index of the entrance vertex */
-      entr1Idx  = pig_GetEntrIdx(pTemp, entr1, exit0);
+      /* entr1Idx,ENTRV = index of the entrance vertex, or -1 if it was
+	 pruned as a dead end, in which case exit0 leads nowhere */
+      entr1Idx  = pig_FindEntrIdx(pTemp, entr1, exit0);
 #ifdef DEBUG_PRINT
       fprintf(outfile,"PE%3d: h: %d orig: %d cur: %d exit0: %3d entr1: %3d entr1Idx: %3d\n",
 	    MYNODE, h, origAdjAssn, curAdjAssn, exit0, entr1, entr1Idx);
@@ -3458,7 +4433,7 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
 
       /* If the Interval arc exists from entr1 to exit0, we have a cycle! */
 
-      if (pig_CheckArc(pTemp, entr1Idx, exit0)) {
+      if ((entr1Idx >= 0) && pig_CheckArc(pTemp, entr1Idx, exit0)) {
 	fprintf(outfile,"PE%3d: HALT: CYCLE DETECTED DURING MERGE (%3d, %3d)\n",
 		MYNODE, exit0, entr1);
 	CYCLE_FOUND = TRUE;
@@ -3468,21 +4443,37 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
       /* Get list of the entrance vertices that have Interval arcs to exit0 */
       pig_GetEntrPred(pTemp, exit0, &entr0Num, &entr0List);
 
-      if (entr0Num > 0) {
+      if ((entr0Num > 0) && (entr1Idx >= 0)) {
 	/* For each Interval of entr1, replace it with the new Interval from
 	   entr0List to exit1 */
 	entr1IntervalNum = pig_GetIntervalCount(pTemp, entr1Idx, ENTRV);
-	if (entr1IntervalNum > 0) {
+	entr1Set = pTemp->newIntervals + entr1Idx;
+	if (entr1IntervalNum + entr1Set->num > 0) {
 #ifdef DEBUG_PRINT
 	  fprintf(outfile,"PE%3d: entr1Idx: %2d [%2d : %2d] entr1IntervalNum: %2d\n",
 		  MYNODE, entr1Idx, pig_GetLabel(pTemp, entr1Idx, ENTRV),
 		  entr1, entr1IntervalNum);
 #endif
 
+#ifdef USE_OPENMP
+	  if ((long)entr0Num*(entr1IntervalNum + entr1Set->num) >=
+	      OMP_MERGE_MINWORK)
+	    pig_AddIntervalsOmp(pTemp, entr0List, entr0Num, entr1Idx);
+	  else
+#endif
 	  for (p=0 ; p<entr0Num ; p++) {
-	    for (s=0 ; s<entr1IntervalNum ; s++) {
-	      minval = pig_GetIntervalC0(pTemp, entr1Idx, s);
-	      maxval = pig_GetIntervalC1(pTemp, entr1Idx, s);
+	    /* entr1's own intervals, then those it gained in this merge */
+	    for (s=0 ; s<entr1IntervalNum + entr1Set->num ; s++) {
+	      if (s < entr1IntervalNum) {
+		minval = pig_GetIntervalC0(pTemp, entr1Idx, s);
+		maxval = pig_GetIntervalC1(pTemp, entr1Idx, s);
+	      }
+	      else {
+		minval = entr1Set->iv[2*(s-entr1IntervalNum)];
+		maxval = entr1Set->iv[2*(s-entr1IntervalNum)+1];
+	      }
+	      if (maxval < minval)
+		continue;
 	      if (!pig_CheckInterval(pTemp, entr0List[p], minval, maxval)) {
 #ifdef DEBUG_PRINT
 		fprintf(outfile,"PE%3d: Adding  Interval (%3d, [%3d %3d]) idx %3d\n",
@@ -3515,13 +4506,22 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
       free(entr0List);
       
       pig_RemoveVertex(pTemp, exit0Idx, EXITV);
-      pig_RemoveVertex(pTemp, entr1Idx, ENTRV);
+      if (entr1Idx >= 0)
+	pig_RemoveVertex(pTemp, entr1Idx, ENTRV);
 	    
-    } /* (curAdjAssn  == MYNODE) */
+    } /* (curAdjAssn  == MERGENODE) */
     
   } /* foreach exit0 */
 
+#if PRUNE_DEADENDS
+  pig_RemoveOrphans(pTemp, h);
+#endif
+  pig_FreeIndex(pTemp);
   pig_CleanUp(pTemp);
+#if PRUNE_DEADENDS
+  if (pig_Prune(pTemp) > 0)
+    pig_CleanUp(pTemp);
+#endif
 
 #ifdef DEBUG_PRINT
   Print_myIntervalPack(pTemp);
@@ -3533,56 +4533,269 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
   return;
 }
 
+int Merge_FanInLog(int maxBytes) {
+  /* log2 of the fan-in for the next stage, given the largest pack */
+  int b;
+
+  b = MERGE_FANIN_LOG;
+  while ((b > 1) &&
+	 (2.0 * (double)(1<<b) * (double)maxBytes > (double)MERGE_FANIN_MAXBYTES))
+    b--;
+  return (b);
+}
+
+void Merge_Plan(pIntervalGraph_t pig) {
+  /* Place the ranks at the leaves of the merge tree and renumber the
+     pack's adjAssn fields as tree positions.  Every rank gathers the
+     nonzero trans-arc counts between rank pairs, as (count, r, s)
+     records, and builds the same tree bottom up: at each level the
+     clusters are paired by greedy heavy-edge matching, heaviest
+     boundary first, and the second of a pair is shifted into the upper
+     half of the pair's block.  Clusters left with no neighbour to pair
+     with are paired in index order, so with no preference the pairs
+     come out as the rank-bit ones. */
+  int *pos;
+  int logp, size, i, r;
+#if MERGE_HEAVYEDGE
+  int *cnt, *edgeNum, *edgeOff, *edges, *pairs, *clus, *mate, *newIdx;
+  int eNum, myNum, pNum, c, cNew, L, a, b, k;
+#endif
+
+  logp = log2_i(NODES);
+  size = 1<<logp;
+
+  mergeRank = (int *)SAFE_MALLOC(size*sizeof(int), "(cycleConvex.c) mergeRank");
+  pos       = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleConvex.c) pos");
+  for (r=0 ; r<NODES ; r++)
+    pos[r] = r;
+
+#if MERGE_HEAVYEDGE
+  cnt     = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleConvex.c) cnt");
+  edgeNum = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleConvex.c) edgeNum");
+  edgeOff = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleConvex.c) edgeOff");
+  clus    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleConvex.c) clus");
+  mate    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleConvex.c) mate");
+  newIdx  = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleConvex.c) newIdx");
+
+  for (r=0 ; r<NODES ; r++)
+    cnt[r] = 0;
+  for (i=0 ; i<pig->exitNum ; i++)
+    cnt[pig_GetAdjAssn(pig, i, EXITV)]++;
+  myNum = 0;
+  for (r=0 ; r<NODES ; r++)
+    if ((r != MYNODE) && (cnt[r] > 0))
+      myNum++;
+
+  MPI_Allgather(&myNum, 1, MPI_INT, edgeNum, 1, MPI_INT, MPI_COMM_WORLD);
+  eNum = 0;
+  for (r=0 ; r<NODES ; r++) {
+    edgeOff[r]  = 3*eNum;
+    eNum       += edgeNum[r];
+    edgeNum[r] *= 3;
+  }
+  edges = (int *)SAFE_MALLOC((3*eNum + 1)*sizeof(int), "(cycleConvex.c) edges");
+  pairs = (int *)SAFE_MALLOC((3*eNum + 1)*sizeof(int), "(cycleConvex.c) pairs");
+
+  /* This rank's nonzero row, sent from pairs */
+  k = 0;
+  for (r=0 ; r<NODES ; r++)
+    if ((r != MYNODE) && (cnt[r] > 0)) {
+      pairs[k++] = cnt[r];
+      pairs[k++] = MYNODE;
+      pairs[k++] = r;
+    }
+  MPI_Allgatherv(pairs, 3*myNum, MPI_INT, edges, edgeNum, edgeOff, MPI_INT,
+		 MPI_COMM_WORLD);
+
+  for (r=0 ; r<NODES ; r++) {
+    clus[r] = r;
+    pos[r]  = 0;
+  }
+  c = NODES;
+  for (L=0 ; L<logp ; L++) {
+    /* Trans arcs between the clusters of this level, both directions
+       summed under (lower, upper) cluster */
+    pNum = 0;
+    for (i=0 ; i<eNum ; i++) {
+      a = clus[edges[3*i+1]];
+      b = clus[edges[3*i+2]];
+      if (a != b) {
+	pairs[3*pNum]   = edges[3*i];
+	pairs[3*pNum+1] = min(a,b);
+	pairs[3*pNum+2] = max(a,b);
+	pNum++;
+      }
+    }
+    qsort(pairs, pNum, 3*sizeof(int), pairCompareEnds);
+    k = 0;
+    for (i=0 ; i<pNum ; i++) {
+      if ((k > 0) &&
+	  (pairs[3*(k-1)+1] == pairs[3*i+1]) &&
+	  (pairs[3*(k-1)+2] == pairs[3*i+2]))
+	pairs[3*(k-1)] += pairs[3*i];
+      else {
+	pairs[3*k]   = pairs[3*i];
+	pairs[3*k+1] = pairs[3*i+1];
+	pairs[3*k+2] = pairs[3*i+2];
+	k++;
+      }
+    }
+    pNum = k;
+    qsort(pairs, pNum, 3*sizeof(int), pairCompareWeight);
+
+    for (i=0 ; i<c ; i++)
+      mate[i] = -1;
+    for (i=0 ; i<pNum ; i++) {
+      a = pairs[3*i+1];
+      b = pairs[3*i+2];
+      if ((mate[a] < 0) && (mate[b] < 0)) {
+	mate[a] = b;
+	mate[b] = a;
+      }
+    }
+    /* The rest share no trans arcs with each other: pair them in
+       index order */
+    a = -1;
+    for (i=0 ; i<c ; i++)
+      if (mate[i] < 0) {
+	if (a < 0)
+	  a = i;
+	else {
+	  mate[a] = i;
+	  mate[i] = a;
+	  a = -1;
+	}
+      }
+
+    /* A pair's lower cluster keeps its positions and leads the merge;
+       an odd cluster out waits for the next level with an empty half */
+    cNew = 0;
+    for (i=0 ; i<c ; i++)
+      if ((mate[i] < 0) || (i < mate[i])) {
+	newIdx[i] = cNew;
+	if (mate[i] >= 0)
+	  newIdx[mate[i]] = cNew;
+	cNew++;
+      }
+    for (r=0 ; r<NODES ; r++) {
+      a = clus[r];
+      if ((mate[a] >= 0) && (mate[a] < a))
+	pos[r] += 1<<L;
+      clus[r] = newIdx[a];
+    }
+    c = cNew;
+  }
+
+  free(pairs);
+  free(edges);
+  free(newIdx);
+  free(mate);
+  free(clus);
+  free(edgeOff);
+  free(edgeNum);
+  free(cnt);
+#endif
+
+  for (i=0 ; i<size ; i++)
+    mergeRank[i] = -1;
+  for (r=0 ; r<NODES ; r++)
+    mergeRank[pos[r]] = r;
+  MERGENODE = pos[MYNODE];
+
+#ifdef DEBUG_PRINT
+  if (MYNODE==0)
+    for (i=0 ; i<size ; i++)
+      fprintf(outfile,"PE%3d: merge position %3d: rank %3d\n",
+	      MYNODE, i, mergeRank[i]);
+#endif
+
+  /* From here on adjAssn holds a tree position; the pack is compact */
+  for (i=0 ; i<pig->entrNum ; i++)
+    pig_SetAdjAssn(pig, i, ENTRV, pos[pig_GetAdjAssn(pig, i, ENTRV)]);
+  for (i=0 ; i<pig->exitNum ; i++)
+    pig_SetAdjAssn(pig, i, EXITV, pos[pig_GetAdjAssn(pig, i, EXITV)]);
+  pig_SortExitsByStage(pig);
+
+  free(pos);
+  return;
+}
+
 void Merge_IntervalPack(pIntervalGraph_t *pig) {
-  int h;
+  int h, lo, j, from, num;
   int logp;
-  pIntervalGraph_t pIntervalGraph_recv;
-  int found, result;
+  pIntervalGraph_t *pRecv, pCat;
+  int stat[2], result[2];
 
   /* logp is the ceiling of log2(NODES) */
   logp = log2_i(NODES);
-  for (h=0 ; h<logp ; h++) {
+  Merge_Plan(*pig);
+  pRecv = (pIntervalGraph_t *)SAFE_MALLOC((1<<MERGE_FANIN_LOG)*sizeof(pIntervalGraph_t),
+					  "(cycleConvex.c) pRecv");
+
+  stat[0] = 0;
+  stat[1] = pig_GetDataInBytes(*pig);
+  MPI_Allreduce(stat, result, 2, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+  /* Each pass covers binary stages lo..h, merging the group of tree
+     positions that differ only in those bits onto the one with them all
+     clear */
+  for (lo=0 ; lo<logp ; lo=h+1) {
+    h = min(lo + Merge_FanInLog(result[1]), logp) - 1;
 #if PRINT_MERGESIZE
     MPI_Barrier(MPI_COMM_WORLD);
 #endif
-    if (lastB(MYNODE, h)==0) {
+    stat[1] = 0;
+    if (lastB(MERGENODE, lo)==0) {
 #if PRINT_MERGESIZE
       fprintf(outfile,"PE%3d: [%3d] entr: %12d exit: %12d exarcs: %12d\n",
-	      MYNODE, h, (*pig)->entrNum, (*pig)->exitNum, (*pig)->arcNum);
+	      MYNODE, h, (*pig)->entrNum, (*pig)->exitNum, (*pig)->intervalNum);
 #endif
-      if (testB(MYNODE,h)==0) {
-	/* Make sure that if we're not using a power-of-two nodes
-	   that we just sit idle for a stage where our partner is missing */
-	if (setB(MYNODE,h) < NODES) {
+      if (clearLastB(MERGENODE, h) == MERGENODE) {
+	/* Positions left empty when NODES is not a power of two are
+	   skipped; with none filled we sit idle this stage */
+	num = 0;
+	for (j=1 ; j<(1<<(h-lo+1)) ; j++) {
+	  from = mergeRank[MERGENODE + (j<<lo)];
+	  if (from >= 0) {
 #ifdef DEBUG_PRINT
-	  fprintf(outfile,"PE%3d: (h:%3d) I'm receiving from PE%3d\n",
-		  MYNODE, h, setB(MYNODE,h));
-	  fflush(outfile);
+	    fprintf(outfile,"PE%3d: (h:%3d) I'm receiving from PE%3d\n",
+		    MYNODE, h, from);
+	    fflush(outfile);
 #endif
-	  Recv_IntervalPack(&pIntervalGraph_recv, setB(MYNODE,h));
-	  IntervalMerge(pig, pIntervalGraph_recv, h);
-
-	  Free_IntervalPack(pIntervalGraph_recv);
+	    Recv_IntervalPack(pRecv + num, from);
+	    num++;
+	  }
 	}
+	if (num > 0) {
+	  if (num == 1)
+	    pCat = pRecv[0];
+	  else {
+	    pCat = pig_ConcatPacks(pRecv, num);
+	    for (j=0 ; j<num ; j++)
+	      Free_IntervalPack(pRecv[j]);
+	  }
+	  IntervalMerge(pig, pCat, h);
+	  Free_IntervalPack(pCat);
+	}
+	stat[1] = pig_GetDataInBytes(*pig);
       }
       else {
 #ifdef DEBUG_PRINT
 	fprintf(outfile,"PE%3d: (h:%3d) I'm sending to PE%3d\n",
-		MYNODE, h, clearB(MYNODE,h));
+		MYNODE, h, mergeRank[clearLastB(MERGENODE, h)]);
 	fflush(outfile);
 #endif
-	Send_IntervalPack(*pig, clearB(MYNODE,h));
+	Send_IntervalPack(*pig, mergeRank[clearLastB(MERGENODE, h)]);
       }
     }
-#if 1
-    found = (CYCLE_FOUND==TRUE)?1:0;
-    MPI_Allreduce(&found, &result, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
-    if (result)
-      return;
-#else
-    MPI_Barrier(MPI_COMM_WORLD);
-#endif
+    /* A cycle anywhere, and the largest pack left for the next stage */
+    stat[0] = (CYCLE_FOUND==TRUE)?1:0;
+    MPI_Allreduce(stat, result, 2, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (result[0])
+      break;
   }
+  free(pRecv);
+  free(mergeRank);
   return;
 }
 
@@ -3613,19 +4826,23 @@ void main(int argc, char **argv) {
   vertexList_t myVerts;
   int initTransArcCount, termTransArcCount;
   transArc_t *initTransArcs, *termTransArcs;
+#if !(DIRECT_PACK && !USE_PEG)
   eGraph_t expGraph;
+#endif
 #if USE_PEG
   pExpGraph_t pExpGraph;
 #else
   pIntervalGraph_t pIntervalGraph;
 #endif
   int found, result;
+  int backArcs;
 
   timer_init();
   
   MPI_Init(&argc, &argv);
   MPI_Comm_rank(MPI_COMM_WORLD, &MYNODE);
   MPI_Comm_size(MPI_COMM_WORLD, &NODES);
+  MERGENODE = MYNODE;
 
   outfile = stdout;
 #if 0
@@ -3669,12 +4886,18 @@ void main(int argc, char **argv) {
   timer_mark("Print Input");
 #endif
 
+  backArcs = 1;
+#if BACKARC_PRUNE
+  backArcs = Backarc_Restrict(myVerts);
+  timer_mark("Backarc_Restrict");
+#endif
+
   Find_Local_Cycles(myVerts);
   timer_mark("Find Local Cycles");
 
   found = (CYCLE_FOUND==TRUE)?1:0;
   MPI_Allreduce(&found, &result, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
-  if (!result) {
+  if ((!result) && (backArcs > 0)) {
   
     Discovery(myVerts,
 	      &initTransArcCount, 
@@ -3683,6 +4906,7 @@ void main(int argc, char **argv) {
 	      &termTransArcs);
     timer_mark("Discovery");
 
+#if !(DIRECT_PACK && !USE_PEG)
     Create_Express(myVerts,
 		   initTransArcCount, 
 		   initTransArcs,
@@ -3695,6 +4919,7 @@ void main(int argc, char **argv) {
     Print_Express(expGraph);
     timer_mark("Print_Express");
 #endif
+#endif
     
 #if USE_PEG
     Create_ExpressPack(expGraph, &pExpGraph);
@@ -3710,9 +4935,24 @@ void main(int argc, char **argv) {
 
     Free_ExpressPack(pExpGraph);
 #else /* USE_PIG */
+#if DIRECT_PACK
+    Create_IntervalPack_Direct(myVerts,
+			       initTransArcCount,
+			       initTransArcs,
+			       termTransArcCount,
+			       termTransArcs,
+			       &pIntervalGraph);
+#else
     Create_IntervalPack(expGraph, &pIntervalGraph);
+#endif
     timer_mark("Create_IntervalPack");
 
+#if PRUNE_DEADENDS
+    if (pig_Prune(pIntervalGraph) > 0)
+      pig_CleanUp(pIntervalGraph);
+    timer_mark("Prune_IntervalPack");
+#endif
+
 #ifdef DEBUG_PRINT
     Print_IntervalPack(pIntervalGraph);
     timer_mark("Print_IntervalPack");
@@ -3724,7 +4964,9 @@ void main(int argc, char **argv) {
     Free_IntervalPack(pIntervalGraph);
 #endif
     
+#if !(DIRECT_PACK && !USE_PEG)
     Free_Express(expGraph);
+#endif
     free(termTransArcs);
     free(initTransArcs);
   }
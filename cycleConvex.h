@@ -96,6 +96,7 @@ typedef struct labelLookup_s {
 } *labelLookup_t;
 
 #define ENTR_LUT 0
+#define EXIT_DIRECT 1
 typedef struct eGraph_s {
   int entrNum;           /* Number of entrance vertices */
   int exitNum;           /* Number of exit vertices */
@@ -105,8 +106,12 @@ typedef struct eGraph_s {
   labelLookup_t entrLUT; /* Table from vertex label -> express vertex */
   int entrLUTNum;        /* Number of filled LUT entries */
 #endif
+#if EXIT_DIRECT
+  expVertex_t *exitDirect; /* Table from local vertex index -> exit vertex */
+#else
   labelLookup_t exitLUT; /* Table from vertex label -> express vertex */
   int exitLUTNum;        /* Number of filled LUT entries */
+#endif
 } *eGraph_t;
 
 /***************************************************************/
@@ -138,18 +143,27 @@ typedef struct pExpGraph_s {
 
 /***************************************************************/
 
-typedef struct pInterval_s {
-  int idx;
-  int C0;
-  int C1;
-  struct pInterval_s *next;
-} *pInterval_t;
-
-typedef struct pIntervalFlat_s {
-  int idx;
-  int C0;
-  int C1;
-} *pIntervalFlat_t;
+/* Intervals added to one entrance during a merge, kept sorted by C0
+   and coalesced (no two overlap or touch) */
+typedef struct pIntervalSet_s {
+  int  num;              /* Number of intervals in the set */
+  int  size;             /* Number of intervals allocated */
+  int *iv;               /* (C0, C1) pairs */
+} *pIntervalSet_t;
+
+/* Lookup tables built over a packed interval graph for one merge */
+typedef struct pigIndex_s {
+  int  labelSize;        /* Size of the label hash table (power of 2) */
+  int  labelNum;         /* Number of labels in the table */
+  int *labelKey;         /* Label held in each slot, -1 if empty */
+  int *labelLive;        /* Number of live exits with this label */
+  int *labelRef;         /* First interval with this label as an endpoint */
+  int  refNum;           /* Number of endpoint records in use */
+  int  refMax;           /* Number of endpoint records allocated */
+  int *refEntr;          /* Entrance holding the interval */
+  int *refInt;           /* Interval number within that entrance */
+  int *refNext;          /* Next record for the same label, -1 if none */
+} *pigIndex_t;
 
 typedef struct pIntervalGraph_s {
   int entrNum;           /* Number of entrance vertices */
@@ -162,9 +176,10 @@ typedef struct pIntervalGraph_s {
   int deadExit;
   BOOL *deadEntrMask;
   BOOL *deadExitMask;
-  pInterval_t newIntervals;
+  struct pIntervalSet_s *newIntervals; /* Intervals to merge in, per entrV */
   int deadInt;
   int newInt;
+  struct pigIndex_s *index; /* Lookup tables, only present during a merge */
 } *pIntervalGraph_t;
 
 /***************************************************************/
@@ -162,6 +162,7 @@ static char rcsid[] = "$Id: cycleInterval.c,v 1.6 1999/07/15 01:00:31 dbader Exp
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 #include "mpi.h"
 #include "misc.h"
 #include "cycleInterval.h"
@@ -175,6 +176,40 @@ static char rcsid[] = "$Id: cycleInterval.c,v 1.6 1999/07/15 01:00:31 dbader Exp
 
 #define PRINT_MERGESIZE 0
 
+/* Fan-in of the merge tree: a stage merges up to 2^MERGE_FANIN_LOG packs
+   on one rank and eliminates every exit internal to that group at once.
+   The fan-in drops, down to 2, while that many copies of the largest
+   current pack would exceed MERGE_FANIN_MAXBYTES */
+#define MERGE_FANIN_LOG      2
+#define MERGE_FANIN_MAXBYTES (256*1024*1024)
+
+/* Lay out the merge tree by greedy heavy-edge matching on the number of
+   trans arcs between ranks (see Merge_Plan), so ranks sharing the most
+   boundary merge first; 0 pairs ranks by their bits.  Only rank pairs
+   that share trans arcs are gathered, so planning costs O(E log E) for
+   E such pairs, not O(NODES^2) */
+#define MERGE_HEAVYEDGE 1
+
+/* Send a pack as one message, its size header in front of the data; the
+   receiver sizes it with MPI_Mprobe.  0 sends the header and the data as
+   two messages */
+#define PACK_ONEMSG 1
+
+/* Build the packed interval graph directly from the per-vertex [C0, C1]
+   reach intervals instead of going through the linked eGraph_t */
+#define DIRECT_PACK 1
+
+/* Drop entrances whose interval chain holds no live exit label and exits
+   that no live entrance's chain holds, after building the pack and after
+   each merge */
+#define PRUNE_DEADENDS 1
+
+/* Restrict the input to the label windows spanned by back arcs before
+   Discovery, and skip the merge when there are none (see
+   Backarc_Restrict) */
+#define BACKARC_PRUNE 1
+#define BACKARC_GATHERMAX (1<<16)
+
 /*********************************************************/
 #define INPUT_LATTICE     0
 #define INPUT_LINEAR      1
@@ -214,6 +249,8 @@ int (*localIndex_func[])() = {
 BOOL CYCLE_FOUND;
 
 int MYNODE, NODES;
+int MERGENODE;    /* Position of this rank in the merge tree */
+int *mergeRank;   /* Rank at each merge tree position, -1 if none */
 FILE *outfile;
 FILE *errfile;
 
@@ -221,6 +258,7 @@ char *INPUT_GRAPH_NAME;
 
 #define MPI_TAG_SIZES   0
 #define MPI_TAG_DATA    1
+#define MPI_TAG_PACK    2
 
 #define ENTRV           0
 #define EXITV           1
@@ -241,16 +279,44 @@ int randrange(int a, int b) {
   return (randmax(range) + a);
 }
 
-#if 0
 static int intCompare(const void *a, const void *b) {
   return (*(int *)a - *(int *)b);
 }
-#endif
+
+static int intPairCompare(const void *a, const void *b) {
+  int d;
+  d = *(int *)a - *(int *)b;
+  if (d == 0)
+    d = *((int *)a + 1) - *((int *)b + 1);
+  return (d);
+}
 
 static int transArcCompareHead(const void *a, const void *b) {
   return (((transArc_t *)a)->headAssn - ((transArc_t *)b)->headAssn);
 }
 
+#if MERGE_HEAVYEDGE
+static int pairCompareWeight(const void *a, const void *b) {
+  /* (weight, i, j) records: heaviest first, then by i and j */
+  const int *x = (const int *)a;
+  const int *y = (const int *)b;
+  if (x[0] != y[0])
+    return ((x[0] > y[0]) ? -1 : 1);
+  if (x[1] != y[1])
+    return (x[1] - y[1]);
+  return (x[2] - y[2]);
+}
+
+static int pairCompareEnds(const void *a, const void *b) {
+  /* (weight, i, j) records: by i and j */
+  const int *x = (const int *)a;
+  const int *y = (const int *)b;
+  if (x[1] != y[1])
+    return (x[1] - y[1]);
+  return (x[2] - y[2]);
+}
+#endif
+
 static int expGraphLabelCompare(const void *a, const void *b) {
   return (((labelLookup_t)a)->label - ((labelLookup_t)b)->label);
 }
@@ -735,6 +801,136 @@ void visitLocal(vertexList_t verts, int vidx,
   return;
 }
 
+/*************************************************************************/
+/* Back-arc windows.  An arc (u, v) with label(v) <= label(u) is a back  */
+/* arc, and every other arc climbs in label.  Going around a cycle the   */
+/* labels only fall along its back arcs, so each label on the cycle lies */
+/* in [label(v), label(u)] of one of them.  Arcs touching a vertex       */
+/* outside the union of these windows cannot be on a cycle.              */
+/*************************************************************************/
+
+BOOL Backarc_InWindow(int *win, int winNum, int x) {
+  /* win holds winNum sorted, disjoint [C0, C1] pairs */
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = winNum;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (win[2*mid] <= x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return ((lo > 0) && (x <= win[2*(lo-1)+1]));
+}
+
+int Backarc_Restrict(vertexList_t verts) {
+  /* Drop every arc that cannot lie on a cycle and return the global
+     number of back arcs; with none the graph is acyclic */
+  int i, j, k, myNum, total, winNum;
+  int *myWin, *win, *cnt, *offset;
+  int bound[2], gbound[2];
+  vertex_t v;
+
+  myNum = 0;
+  for (i=0 ; i<verts->num ; i++) {
+    v = verts->vlist + i;
+    for (j=0 ; j<v->arcs ; j++)
+      if (v->alist[j].head <= v->label)
+	myNum++;
+  }
+
+  MPI_Allreduce(&myNum, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  myWin = (int *)SAFE_MALLOC((2*myNum+2)*sizeof(int), "(cycleInterval.c) myWin");
+  k = 0;
+  bound[0] = INT_MAX;
+  bound[1] = INT_MAX;
+  for (i=0 ; i<verts->num ; i++) {
+    v = verts->vlist + i;
+    for (j=0 ; j<v->arcs ; j++) {
+      if (v->alist[j].head <= v->label) {
+	myWin[k++] = v->alist[j].head;
+	myWin[k++] = v->label;
+	if (v->alist[j].head < bound[0])
+	  bound[0] = v->alist[j].head;
+	if (-v->label < bound[1])
+	  bound[1] = -v->label;
+      }
+    }
+  }
+
+  if (total <= BACKARC_GATHERMAX) {
+    /* Few enough to give every node every window */
+    cnt    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleInterval.c) cnt");
+    offset = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleInterval.c) offset");
+    k = 2*myNum;
+    MPI_Allgather(&k, 1, MPI_INT, cnt, 1, MPI_INT, MPI_COMM_WORLD);
+    offset[0] = 0;
+    for (i=1 ; i<NODES ; i++)
+      offset[i] = offset[i-1] + cnt[i-1];
+    win = (int *)SAFE_MALLOC((2*total+2)*sizeof(int), "(cycleInterval.c) win");
+    MPI_Allgatherv(myWin, 2*myNum, MPI_INT,
+		   win, cnt, offset, MPI_INT, MPI_COMM_WORLD);
+    free(offset);
+    free(cnt);
+
+    /* Sort on C0 and coalesce overlapping windows */
+    qsort(win, total, 2*sizeof(int), intCompare);
+    winNum = 0;
+    for (i=0 ; i<total ; i++) {
+      if ((winNum > 0) && (win[2*i] <= win[2*(winNum-1)+1])) {
+	if (win[2*i+1] > win[2*(winNum-1)+1])
+	  win[2*(winNum-1)+1] = win[2*i+1];
+      }
+      else {
+	win[2*winNum]   = win[2*i];
+	win[2*winNum+1] = win[2*i+1];
+	winNum++;
+      }
+    }
+  }
+  else {
+    /* Otherwise one window from the lowest head to the highest tail;
+       the tail is negated so a single MIN reduction finds both */
+    MPI_Allreduce(bound, gbound, 2, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    win = (int *)SAFE_MALLOC(2*sizeof(int), "(cycleInterval.c) win");
+    win[0] = gbound[0];
+    win[1] = -gbound[1];
+    winNum = 1;
+  }
+  free(myWin);
+
+  k = 0;
+  for (i=0 ; i<verts->num ; i++) {
+    v = verts->vlist + i;
+    if (!Backarc_InWindow(win, winNum, v->label)) {
+      k += v->arcs;
+      v->arcs = 0;
+      continue;
+    }
+    myNum = 0;
+    for (j=0 ; j<v->arcs ; j++)
+      if (Backarc_InWindow(win, winNum, v->alist[j].head))
+	v->alist[myNum++] = v->alist[j];
+    k += v->arcs - myNum;
+    v->arcs = myNum;
+  }
+  free(win);
+
+#ifdef DEBUG_PRINT
+  fprintf(outfile,"PE%3d: back arcs: %d windows: %d arcs dropped: %d\n",
+	  MYNODE, total, winNum, k);
+#endif
+#if PRINT_MERGESIZE
+  if (MYNODE==0)
+    fprintf(outfile,"PE%3d: Back arcs: %d\n",MYNODE,total);
+#endif
+
+  return (total);
+}
+
 void Find_Local_Cycles(vertexList_t verts, int *transArcNum,
 		       transArc_t **transArcs) {
   int i, num;
@@ -1394,24 +1590,358 @@ void pig_SetIntervalNext(pIntervalGraph_t pig, int intIdx, int val) {
   return;
 }
 
-int pig_GetEntrIdx(pIntervalGraph_t pig, int label, int adj) {
+/*************************************************************************/
+/* Per-merge lookup tables:                                              */
+/*   label -> number of live exits with that label                       */
+/*   label -> intervals having that label as an endpoint                 */
+/* Removing the last exit with a label can only change intervals that    */
+/* end at it, so only those are visited.                                 */
+/*************************************************************************/
+
+#define PIG_HASH(x) ((unsigned int)(x) * 2654435761U)
+
+int pig_IndexTableSize(int n) {
+  /* Smallest power of two holding n keys at a load factor of 1/2 */
+  int size;
+  size = 2;
+  while (size < 2*n)
+    size <<= 1;
+  return size;
+}
+
+void pig_IndexGrowLabels(pigIndex_t ix) {
+  /* Double the label table and rehash it.  Endpoint records hang off
+     the slots by index, so they move along unchanged. */
+  unsigned int mask, h;
+  int i, oldSize, *oldKey, *oldLive, *oldRef;
+
+  oldSize = ix->labelSize;
+  oldKey  = ix->labelKey;
+  oldLive = ix->labelLive;
+  oldRef  = ix->labelRef;
+
+  ix->labelSize = 2*oldSize;
+  ix->labelKey  = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleInterval.c) ix->labelKey");
+  ix->labelLive = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleInterval.c) ix->labelLive");
+  ix->labelRef  = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleInterval.c) ix->labelRef");
+  for (i=0 ; i<ix->labelSize ; i++)
+    ix->labelKey[i] = -1;
+
+  mask = (unsigned int)ix->labelSize - 1;
+  for (i=0 ; i<oldSize ; i++)
+    if (oldKey[i] >= 0) {
+      h = PIG_HASH(oldKey[i]) & mask;
+      while (ix->labelKey[h] >= 0)
+	h = (h + 1) & mask;
+      ix->labelKey[h]  = oldKey[i];
+      ix->labelLive[h] = oldLive[i];
+      ix->labelRef[h]  = oldRef[i];
+    }
+
+  free(oldRef);
+  free(oldLive);
+  free(oldKey);
+  return;
+}
+
+int pig_IndexLabelSlot(pigIndex_t ix, int label, BOOL insert) {
+  /* Return the slot of label, inserting it if requested.
+     Returns -1 if the label is absent and not inserted.  An insert that
+     would take the table past half full grows it first, so a probe
+     always reaches an empty slot. */
+  unsigned int mask, h;
+  int probe;
+
+  mask = (unsigned int)ix->labelSize - 1;
+  h = PIG_HASH(label) & mask;
+  for (probe=0 ; ix->labelKey[h] >= 0 ; probe++) {
+    if (ix->labelKey[h] == label)
+      return (int)h;
+    if (probe == ix->labelSize) {
+      fprintf(errfile,"PE%3d: ERROR: label table full (%d slots)\n",
+	      MYNODE, ix->labelSize);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    h = (h + 1) & mask;
+  }
+  if (!insert)
+    return (-1);
+  if (2*(ix->labelNum+1) > ix->labelSize) {
+    pig_IndexGrowLabels(ix);
+    return (pig_IndexLabelSlot(ix, label, TRUE));
+  }
+  ix->labelKey[h]  = label;
+  ix->labelLive[h] = 0;
+  ix->labelRef[h]  = -1;
+  ix->labelNum++;
+  return (int)h;
+}
+
+void pig_IndexAddRef(pigIndex_t ix, int label, int intIdx) {
+  int slot, rec;
+
+  if (label < 0)
+    return;
+
+  if (ix->refNum == ix->refMax) {
+    ix->refMax  = 2*ix->refMax + 16;
+    ix->refInt  = (int *)realloc(ix->refInt,  ix->refMax*sizeof(int));
+    ix->refNext = (int *)realloc(ix->refNext, ix->refMax*sizeof(int));
+    if ((ix->refInt == (int *)NULL) ||
+	(ix->refNext == (int *)NULL))
+      fprintf(errfile,"PE%3d: ERROR: realloc failed in pig_IndexAddRef\n",
+	      MYNODE);
+  }
+
+  slot = pig_IndexLabelSlot(ix, label, TRUE);
+  rec  = ix->refNum++;
+  ix->refInt[rec]     = intIdx;
+  ix->refNext[rec]    = ix->labelRef[slot];
+  ix->labelRef[slot]  = rec;
+  return;
+}
+
+void pig_BuildIndex(pIntervalGraph_t pig) {
+  pigIndex_t ix;
+  int i, n, slot, C0, C1, nextIdx;
+  int *pairs;
+
+  ix = (pigIndex_t)SAFE_MALLOC(sizeof(struct pigIndex_s),
+			       "(cycleInterval.c) pig->index");
+  pig->index = ix;
+
+  /* Room for the exit labels, both endpoints of every interval, and the
+     two endpoints each removed label can shift an interval to */
+  ix->labelSize = pig_IndexTableSize(3*pig->exitNum + 2*pig->intervalNum);
+  ix->labelKey  = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleInterval.c) ix->labelKey");
+  ix->labelLive = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleInterval.c) ix->labelLive");
+  ix->labelRef  = (int *)SAFE_MALLOC(ix->labelSize*sizeof(int),
+				     "(cycleInterval.c) ix->labelRef");
+  for (i=0 ; i<ix->labelSize ; i++)
+    ix->labelKey[i] = -1;
+  ix->labelNum  = 0;
+
+  ix->refNum  = 0;
+  ix->refMax  = 2*pig->intervalNum + 16;
+  ix->refInt   = (int *)SAFE_MALLOC(ix->refMax*sizeof(int),
+				    "(cycleInterval.c) ix->refInt");
+  ix->refNext  = (int *)SAFE_MALLOC(ix->refMax*sizeof(int),
+				    "(cycleInterval.c) ix->refNext");
+
+  for (i=0 ; i<pig->exitNum ; i++)
+    if (pig->deadExitMask[i] == FALSE) {
+      /* The insert may grow the table, so take the slot first */
+      slot = pig_IndexLabelSlot(ix, pig_GetLabel(pig, i, EXITV), TRUE);
+      ix->labelLive[slot]++;
+    }
+
+  for (i=0 ; i<pig->intervalNum ; i++) {
+    C0 = pig_GetIntervalC0(pig, i);
+    C1 = pig_GetIntervalC1(pig, i);
+    pig_IndexAddRef(ix, C0, i);
+    if (C1 != C0)
+      pig_IndexAddRef(ix, C1, i);
+  }
+
+  /* Intervals sorted by (C0, index); C0 only grows during a merge, so
+     this order stays a superset filter for "C0 <= x" */
+  n = pig->intervalNum;
+  pairs = (int *)SAFE_MALLOC((2*n+1)*sizeof(int), "(cycleInterval.c) pairs");
+  for (i=0 ; i<n ; i++) {
+    pairs[2*i]   = pig_GetIntervalC0(pig, i);
+    pairs[2*i+1] = i;
+  }
+  qsort(pairs, n, 2*sizeof(int), intPairCompare);
+
+  ix->order    = (int *)SAFE_MALLOC((n+1)*sizeof(int), "(cycleInterval.c) ix->order");
+  ix->orderC0  = (int *)SAFE_MALLOC((n+1)*sizeof(int), "(cycleInterval.c) ix->orderC0");
+  ix->orderPos = (int *)SAFE_MALLOC((n+1)*sizeof(int), "(cycleInterval.c) ix->orderPos");
+  for (i=0 ; i<n ; i++) {
+    ix->orderC0[i] = pairs[2*i];
+    ix->order[i]   = pairs[2*i+1];
+    ix->orderPos[pairs[2*i+1]] = i;
+  }
+  free(pairs);
+
+  ix->treeSize = 1;
+  while (ix->treeSize < n)
+    ix->treeSize <<= 1;
+  ix->treeC1 = (int *)SAFE_MALLOC(2*ix->treeSize*sizeof(int),
+				  "(cycleInterval.c) ix->treeC1");
+  for (i=0 ; i<2*ix->treeSize ; i++)
+    ix->treeC1[i] = -1;
+  for (i=0 ; i<n ; i++)
+    ix->treeC1[ix->treeSize + i] = pig_GetIntervalC1(pig, ix->order[i]);
+  for (i=ix->treeSize-1 ; i>=1 ; i--)
+    ix->treeC1[i] = max(ix->treeC1[2*i], ix->treeC1[2*i+1]);
+
+  ix->revFirst  = (int *)SAFE_MALLOC((n+1)*sizeof(int), "(cycleInterval.c) ix->revFirst");
+  ix->revNext   = (int *)SAFE_MALLOC((n+1)*sizeof(int), "(cycleInterval.c) ix->revNext");
+  ix->headFirst = (int *)SAFE_MALLOC((n+1)*sizeof(int), "(cycleInterval.c) ix->headFirst");
+  ix->headNext  = (int *)SAFE_MALLOC((pig->entrNum+1)*sizeof(int),
+				     "(cycleInterval.c) ix->headNext");
+  for (i=0 ; i<n ; i++) {
+    ix->revFirst[i]  = -1;
+    ix->revNext[i]   = -1;
+    ix->headFirst[i] = -1;
+  }
+  for (i=0 ; i<n ; i++) {
+    nextIdx = pig_GetIntervalNext(pig, i);
+    if (nextIdx >= 0) {
+      ix->revNext[i] = ix->revFirst[nextIdx];
+      ix->revFirst[nextIdx] = i;
+    }
+  }
+  for (i=0 ; i<pig->entrNum ; i++) {
+    ix->headNext[i] = -1;
+    nextIdx = pig_GetIntervalIndex(pig, i, ENTRV);
+    if (nextIdx >= 0) {
+      ix->headNext[i] = ix->headFirst[nextIdx];
+      ix->headFirst[nextIdx] = i;
+    }
+  }
+
+  ix->stamp    = (int *)SAFE_MALLOC((n+1)*sizeof(int), "(cycleInterval.c) ix->stamp");
+  ix->stabList = (int *)SAFE_MALLOC((n+1)*sizeof(int), "(cycleInterval.c) ix->stabList");
+  ix->queue    = (int *)SAFE_MALLOC((n+1)*sizeof(int), "(cycleInterval.c) ix->queue");
+  for (i=0 ; i<n ; i++)
+    ix->stamp[i] = 0;
+  ix->epoch = 0;
+
+  return;
+}
+
+int pig_IndexStabRec(pigIndex_t ix, int node, int lo, int hi, int p, int x,
+		     int n) {
+  int mid;
+
+  if ((lo >= p) || (ix->treeC1[node] < x))
+    return (n);
+  if (hi - lo == 1) {
+    ix->stabList[n++] = ix->order[lo];
+    return (n);
+  }
+  mid = lo + (hi - lo) / 2;
+  n = pig_IndexStabRec(ix, 2*node,   lo,  mid, p, x, n);
+  n = pig_IndexStabRec(ix, 2*node+1, mid, hi,  p, x, n);
+  return (n);
+}
+
+int pig_IndexStab(pIntervalGraph_t pig, int x) {
+  /* Fill pig->index->stabList with the intervals that contain x, in
+     increasing index order, and return how many there are */
+  pigIndex_t ix;
+  int lo, hi, mid, n, k, m;
+
+  ix = pig->index;
+
+  /* p = number of intervals with build-time C0 <= x */
+  lo = 0;
+  hi = pig->intervalNum;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (ix->orderC0[mid] <= x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  n = pig_IndexStabRec(ix, 1, 0, ix->treeSize, lo, x, 0);
+
+  /* Drop intervals whose C0 has since moved past x */
+  m = 0;
+  for (k=0 ; k<n ; k++) {
+    if ((pig_GetIntervalC0(pig, ix->stabList[k]) <= x) &&
+	(x <= pig_GetIntervalC1(pig, ix->stabList[k])))
+      ix->stabList[m++] = ix->stabList[k];
+  }
+  qsort(ix->stabList, m, sizeof(int), intCompare);
+  return (m);
+}
+
+void pig_IndexUpdateC1(pIntervalGraph_t pig, int intIdx) {
+  /* Refresh the max-C1 tree after interval intIdx shrank or died */
+  pigIndex_t ix;
+  int node;
+
+  ix = pig->index;
+  node = ix->treeSize + ix->orderPos[intIdx];
+  ix->treeC1[node] = pig_GetIntervalC1(pig, intIdx);
+  for (node >>= 1 ; node >= 1 ; node >>= 1)
+    ix->treeC1[node] = max(ix->treeC1[2*node], ix->treeC1[2*node+1]);
+  return;
+}
+
+void pig_LinkInterval(pIntervalGraph_t pig, int intIdx, int nextIdx) {
+  /* Point the (chain-ending) interval intIdx at nextIdx */
+  pigIndex_t ix;
+
+  pig_SetIntervalNext(pig, intIdx, nextIdx);
+  ix = pig->index;
+  if ((ix != (pigIndex_t)NULL) && (nextIdx >= 0)) {
+    ix->revNext[intIdx] = ix->revFirst[nextIdx];
+    ix->revFirst[nextIdx] = intIdx;
+  }
+  return;
+}
+
+void pig_FreeIndex(pIntervalGraph_t pig) {
+  pigIndex_t ix;
+
+  ix = pig->index;
+  if (ix == (pigIndex_t)NULL)
+    return;
+  free(ix->queue);
+  free(ix->stabList);
+  free(ix->stamp);
+  free(ix->headNext);
+  free(ix->headFirst);
+  free(ix->revNext);
+  free(ix->revFirst);
+  free(ix->treeC1);
+  free(ix->orderPos);
+  free(ix->orderC0);
+  free(ix->order);
+  free(ix->refNext);
+  free(ix->refInt);
+  free(ix->labelRef);
+  free(ix->labelLive);
+  free(ix->labelKey);
+  free(ix);
+  pig->index = (pigIndex_t)NULL;
+  return;
+}
+
+int pig_FindEntrIdx(pIntervalGraph_t pig, int label, int adj) {
+  /* Index of the live entrance (label, adj), or -1 if there is none */
   int i;
   
   for (i=0 ; i<pig->entrNum ; i++) {
     if ((pig_GetLabel(pig, i, ENTRV) == label) &&
-	(pig_GetAdj(pig, i, ENTRV) == adj))
+	(pig_GetAdj(pig, i, ENTRV) == adj) &&
+	(pig->deadEntrMask[i] == FALSE))
       return(i);
   }
-
-  fprintf(errfile,"PE%3d: ERROR: pig_GetEntrIdx()\n",MYNODE);
   return (-1);
 }
 
-void pig_Init(pIntervalGraph_t pig) {
+int pig_GetEntrIdx(pIntervalGraph_t pig, int label, int adj) {
+  int i;
+
+  i = pig_FindEntrIdx(pig, label, adj);
+  if (i < 0)
+    fprintf(errfile,"PE%3d: ERROR: pig_GetEntrIdx()\n",MYNODE);
+  return (i);
+}
+
+void pig_InitAux(pIntervalGraph_t pig) {
+  /* Everything pig_Init sets up but the data itself */
   int i;
-  
-  pig->data    = (int *)SAFE_MALLOC(pig_GetDataInBytes(pig),
-				    "(cycle.c) pig->data");
 
   pig->deadEntr = 0;
   pig->deadExit = 0;
@@ -1427,10 +1957,86 @@ void pig_Init(pIntervalGraph_t pig) {
     *(pig->deadExitMask + i) = FALSE;
 
   pig->deadInt = 0;
+  pig->index = (pigIndex_t)NULL;
   
   return;
 }
 
+void pig_Init(pIntervalGraph_t pig) {
+  pig->data    = (int *)SAFE_MALLOC(pig_GetDataInBytes(pig),
+				    "(cycle.c) pig->data");
+  pig_InitAux(pig);
+  return;
+}
+
+/*************************************************************************/
+/* Exit records sorted by elimination stage; IntervalMerge at stage h    */
+/* walks only the leading run of stage-h exits                           */
+/*************************************************************************/
+
+int pig_ExitStage(pIntervalGraph_t pig, int idx, int h) {
+  /* Stage of exit idx; exits that are already internal count as stage h */
+  return (max(highB(MERGENODE ^ pig_GetAdjAssn(pig, idx, EXITV)), h));
+}
+
+void pig_SortExitsByStage(pIntervalGraph_t pig) {
+  /* Stable counting sort of a freshly built pack's exit records */
+  int count[8*sizeof(int)+1];
+  int *buf, *exitPtr;
+  int i, s, vs;
+
+  vs = pig_GetVSize();
+  exitPtr = pig->data + vs*pig->entrNum;
+  buf = (int *)SAFE_MALLOC(vs*pig->exitNum*sizeof(int) + 1,
+			   "(cycleInterval.c) buf");
+
+  for (s=0 ; s<=8*(int)sizeof(int) ; s++)
+    count[s] = 0;
+  for (i=0 ; i<pig->exitNum ; i++)
+    count[pig_ExitStage(pig, i, 0) + 1]++;
+  for (s=1 ; s<=8*(int)sizeof(int) ; s++)
+    count[s] += count[s-1];
+  for (i=0 ; i<pig->exitNum ; i++) {
+    s = pig_ExitStage(pig, i, 0);
+    memcpy(buf + vs*count[s], exitPtr + vs*i, vs*sizeof(int));
+    count[s]++;
+  }
+  memcpy(exitPtr, buf, vs*pig->exitNum*sizeof(int));
+
+  free(buf);
+  return;
+}
+
+int pig_MergeExits(pIntervalGraph_t pTemp, pIntervalGraph_t p0, pIntervalGraph_t p1, int h) {
+  /* Merge the stage-sorted exits of p0 and p1 into pTemp, whose entrance
+     count must already be set.  Returns the number of exits in stage h, which lead the list. */
+  int i0, i1, k, s0, s1, vs, stageNum;
+  int *dst;
+
+  vs  = pig_GetVSize();
+  dst = pTemp->data + vs*pTemp->entrNum;
+  i0 = i1 = k = 0;
+  stageNum = 0;
+  while ((i0 < p0->exitNum) || (i1 < p1->exitNum)) {
+    s0 = (i0 < p0->exitNum) ? pig_ExitStage(p0, i0, h) : -1;
+    s1 = (i1 < p1->exitNum) ? pig_ExitStage(p1, i1, h) : -1;
+    if ((s1 < 0) || ((s0 >= 0) && (s0 <= s1))) {
+      memcpy(dst + vs*k, p0->data + vs*(p0->entrNum + i0), vs*sizeof(int));
+      if (s0 == h)
+	stageNum++;
+      i0++;
+    }
+    else {
+      memcpy(dst + vs*k, p1->data + vs*(p1->entrNum + i1), vs*sizeof(int));
+      if (s1 == h)
+	stageNum++;
+      i1++;
+    }
+    k++;
+  }
+  return (stageNum);
+}
+
 void Create_IntervalPack(eGraph_t expGraph, pIntervalGraph_t *pIntervalGraph) {
   expVertex_t v;
   pIntervalGraph_t pig;
@@ -1478,6 +2084,64 @@ void Create_IntervalPack(eGraph_t expGraph, pIntervalGraph_t *pIntervalGraph) {
     k++;
     v = v->next;
   }
+  pig_SortExitsByStage(pig);
+
+  return;
+}
+
+void Create_IntervalPack_Direct(vertexList_t verts,
+				int initTransArcCount,
+				transArc_t *initTransArcs,
+				int termTransArcCount,
+				transArc_t *termTransArcs,
+				pIntervalGraph_t *pIntervalGraph)
+{
+  /* Build the packed interval graph straight from the vertex list,
+     filling the same layout (and vertex order) as Create_IntervalPack */
+  pIntervalGraph_t pig;
+  transArc_t *tarc;
+  vertex_t v;
+  int k;
+
+  *pIntervalGraph = (pIntervalGraph_t)SAFE_MALLOC(sizeof(struct pIntervalGraph_s),
+						  "(cycleInterval.c) *pIntervalGraph");
+  pig = *pIntervalGraph;
+
+  pig->entrNum      = termTransArcCount;
+  pig->exitNum      = initTransArcCount;
+  pig->intervalNum  = 1;
+
+  /* Like Create_IntervalPack, only one interval is built: the [C0, C1]
+     reach of the first entrance, which every entrance points to */
+
+  pig_Init(pig);
+
+  pig_SetIntervalC0(pig, 0, -1);
+  pig_SetIntervalC1(pig, 0, -1);
+  pig_SetIntervalNext(pig, 0, -1);
+
+  for (k=0 ; k<pig->entrNum ; k++) {
+    tarc = termTransArcs + (termTransArcCount - 1 - k);
+    pig_SetLabel  (pig, k, ENTRV, tarc->head);
+    pig_SetAdj    (pig, k, ENTRV, tarc->tail);
+    pig_SetAdjAssn(pig, k, ENTRV, tarc->tailAssn);
+    pig_SetIntervalIndex(pig, k, ENTRV, 0);
+
+    if (k == 0) {
+      v = verts->vlist + localIndex(verts, tarc->head);
+      pig_SetIntervalC0(pig, 0, v->C0);
+      pig_SetIntervalC1(pig, 0, v->C1);
+    }
+  }
+
+  for (k=0 ; k<pig->exitNum ; k++) {
+    tarc = initTransArcs + (initTransArcCount - 1 - k);
+    pig_SetLabel  (pig, k, EXITV, tarc->tail);
+    pig_SetAdj    (pig, k, EXITV, tarc->head);
+    pig_SetAdjAssn(pig, k, EXITV, tarc->headAssn);
+    pig_SetIntervalIndex(pig, k, EXITV, -1);
+  }
+  pig_SortExitsByStage(pig);
 
   return;
 }
@@ -1530,6 +2194,8 @@ void Print_IntervalPack(pIntervalGraph_t pig) {
 }
 
 void Free_IntervalPack(pIntervalGraph_t pig) {
+
+  pig_FreeIndex(pig);
   free(pig->deadEntrMask);
   free(pig->deadExitMask);
   if (pig->data != (int *)NULL)
@@ -1538,16 +2204,40 @@ void Free_IntervalPack(pIntervalGraph_t pig) {
   return;
 }
 
+MPI_Datatype Pack_MsgType(int *sizeBuf, int *data, int dataInts) {
+  /* The 3-int size header and the data of a pack, as one message */
+  MPI_Datatype msgType;
+  int          len[2];
+  MPI_Aint     disp[2];
+
+  len[0] = 3;
+  len[1] = dataInts;
+  MPI_Get_address(sizeBuf, disp);
+  MPI_Get_address(data, disp + 1);
+  MPI_Type_create_hindexed(2, len, disp, MPI_INT, &msgType);
+  MPI_Type_commit(&msgType);
+  return (msgType);
+}
+
 void Send_IntervalPack(pIntervalGraph_t pig, int toNode) {
   int sizeBuf[3];
+#if PACK_ONEMSG
+  MPI_Datatype msgType;
+#endif
 
   sizeBuf[0] = pig->entrNum;
   sizeBuf[1] = pig->exitNum;
   sizeBuf[2] = pig->intervalNum;
 
+#if PACK_ONEMSG
+  msgType = Pack_MsgType(sizeBuf, pig->data, pig_GetDataInInts(pig));
+  MPI_Send(MPI_BOTTOM, 1, msgType, toNode, MPI_TAG_PACK, MPI_COMM_WORLD);
+  MPI_Type_free(&msgType);
+#else
   MPI_Send(sizeBuf, 3, MPI_INT, toNode, MPI_TAG_SIZES, MPI_COMM_WORLD);
   MPI_Send(pig->data, pig_GetDataInInts(pig), MPI_INT, toNode, MPI_TAG_DATA,
 	   MPI_COMM_WORLD);
+#endif
   
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: I SENT THIS TO PE%3d\n",MYNODE,toNode);
@@ -1562,11 +2252,31 @@ void Recv_IntervalPack(pIntervalGraph_t *pIntervalGraph, int fromNode) {
   pIntervalGraph_t pig;
   int         sizeBuf[3];
   MPI_Status  mpstat;
+#if PACK_ONEMSG
+  MPI_Message  msg;
+  MPI_Datatype msgType;
+  int          count;
+#endif
   
   *pIntervalGraph = (pIntervalGraph_t)SAFE_MALLOC(sizeof(struct pIntervalGraph_s),
 						  "(cycle.c) *pIntervalGraph");
   pig = *pIntervalGraph;
 
+#if PACK_ONEMSG
+  /* The message size gives the data size; the header comes with it */
+  MPI_Mprobe(fromNode, MPI_TAG_PACK, MPI_COMM_WORLD, &msg, &mpstat);
+  MPI_Get_count(&mpstat, MPI_INT, &count);
+  pig->data = (int *)SAFE_MALLOC((count-3)*sizeof(int),
+				 "(cycle.c) pig->data");
+  msgType = Pack_MsgType(sizeBuf, pig->data, count-3);
+  MPI_Mrecv(MPI_BOTTOM, 1, msgType, &msg, &mpstat);
+  MPI_Type_free(&msgType);
+
+  pig->entrNum      = sizeBuf[0];
+  pig->exitNum      = sizeBuf[1];
+  pig->intervalNum  = sizeBuf[2];
+  pig_InitAux(pig);
+#else
   MPI_Recv(sizeBuf, 3, MPI_INT, fromNode, MPI_TAG_SIZES, MPI_COMM_WORLD,
 	   &mpstat);
 
@@ -1578,6 +2288,7 @@ void Recv_IntervalPack(pIntervalGraph_t *pIntervalGraph, int fromNode) {
   
   MPI_Recv(pig->data, pig_GetDataInInts(pig), MPI_INT, fromNode, MPI_TAG_DATA,
 	   MPI_COMM_WORLD, &mpstat);
+#endif
 
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: I RECEIVED THIS FROM PE%3d\n",MYNODE,fromNode);
@@ -1589,6 +2300,67 @@ void Recv_IntervalPack(pIntervalGraph_t *pIntervalGraph, int fromNode) {
 }
 
 
+pIntervalGraph_t pig_ConcatPacks(pIntervalGraph_t *pList, int num) {
+  /* One compact pack holding the vertices and intervals of num compact
+     packs, with the exits re-sorted by stage.  Interval indices of each
+     pack are shifted past the intervals of the packs before it. */
+  pIntervalGraph_t pig;
+  int *ptr;
+  int i, j, vs, is, entrOff, intOffset, intIdx;
+
+  vs = pig_GetVSize();
+  is = pig_GetISize();
+
+  pig = (pIntervalGraph_t)SAFE_MALLOC(sizeof(struct pIntervalGraph_s),
+				      "(cycleInterval.c) pig");
+  pig->entrNum     = 0;
+  pig->exitNum     = 0;
+  pig->intervalNum = 0;
+  for (j=0 ; j<num ; j++) {
+    pig->entrNum     += pList[j]->entrNum;
+    pig->exitNum     += pList[j]->exitNum;
+    pig->intervalNum += pList[j]->intervalNum;
+  }
+
+  pig_Init(pig);
+
+  ptr = pig->data;
+  for (j=0 ; j<num ; j++) {
+    memcpy(ptr, pList[j]->data, vs*pList[j]->entrNum*sizeof(int));
+    ptr += vs*pList[j]->entrNum;
+  }
+  for (j=0 ; j<num ; j++) {
+    memcpy(ptr, pList[j]->data + vs*pList[j]->entrNum,
+	   vs*pList[j]->exitNum*sizeof(int));
+    ptr += vs*pList[j]->exitNum;
+  }
+  for (j=0 ; j<num ; j++) {
+    memcpy(ptr, pList[j]->data + vs*(pList[j]->entrNum + pList[j]->exitNum),
+	   is*pList[j]->intervalNum*sizeof(int));
+    ptr += is*pList[j]->intervalNum;
+  }
+
+  entrOff   = pList[0]->entrNum;
+  intOffset = pList[0]->intervalNum;
+  for (j=1 ; j<num ; j++) {
+    for (i=entrOff ; i<entrOff+pList[j]->entrNum ; i++) {
+      intIdx = pig_GetIntervalIndex(pig, i, ENTRV);
+      if (intIdx >= 0)
+	pig_SetIntervalIndex(pig, i, ENTRV, intIdx + intOffset);
+    }
+    for (i=intOffset ; i<intOffset+pList[j]->intervalNum ; i++) {
+      intIdx = pig_GetIntervalNext(pig, i);
+      if (intIdx >= 0)
+	pig_SetIntervalNext(pig, i, intIdx + intOffset);
+    }
+    entrOff   += pList[j]->entrNum;
+    intOffset += pList[j]->intervalNum;
+  }
+
+  pig_SortExitsByStage(pig);
+  return (pig);
+}
+
 BOOL pig_CheckArcHead(pIntervalGraph_t pig, int idx, int target) {
   int minval, maxval;
   int intIdx, nextIdx;
@@ -1607,12 +2379,43 @@ BOOL pig_CheckArcHead(pIntervalGraph_t pig, int idx, int target) {
 
 
 void pig_GetEntrPred(pIntervalGraph_t pig, int label, int *num, int **listPred) {
-  int i, n;
+  int i, n, e, r;
+  int qHead, qTail;
+  pigIndex_t ix;
 
   *listPred = (int *)SAFE_MALLOC(pig->entrNum * sizeof(int),
 				 "(cycle.c) *listPred");
 
   n=0;
+  ix = pig->index;
+  if (ix != (pigIndex_t)NULL) {
+    /* An entrance is a pred if its chain reaches an interval holding
+       label; walk the chains backwards from those intervals */
+    ix->epoch++;
+    qTail = pig_IndexStab(pig, label);
+    for (i=0 ; i<qTail ; i++) {
+      ix->queue[i] = ix->stabList[i];
+      ix->stamp[ix->queue[i]] = ix->epoch;
+    }
+    qHead = 0;
+    while (qHead < qTail) {
+      i = ix->queue[qHead++];
+      for (e = ix->headFirst[i] ; e >= 0 ; e = ix->headNext[e]) {
+	*(*listPred + n) = e;
+	n++;
+      }
+      for (r = ix->revFirst[i] ; r >= 0 ; r = ix->revNext[r]) {
+	if (ix->stamp[r] != ix->epoch) {
+	  ix->stamp[r] = ix->epoch;
+	  ix->queue[qTail++] = r;
+	}
+      }
+    }
+    qsort(*listPred, n, sizeof(int), intCompare);
+    *num = n;
+    return;
+  }
+
   for (i=0 ; i<pig->entrNum ; i++) {
     if (pig_CheckArcHead(pig, i, label)) {
       *(*listPred + n) = i; 
@@ -1630,10 +2433,18 @@ void pig_GetEntrPred(pIntervalGraph_t pig, int label, int *num, int **listPred)
 
 
 BOOL pig_CheckInterval(pIntervalGraph_t pig, int C0, int C1) {
-  int s;
+  int s, n;
   BOOL found;
   
   found = FALSE;
+  if (pig->index != (pigIndex_t)NULL) {
+    n = pig_IndexStab(pig, C0);
+    for (s=0 ; (s<n) && (!found) ; s++)
+      found = ((pig_GetIntervalC0(pig, pig->index->stabList[s]) == C0) &&
+	       (pig_GetIntervalC1(pig, pig->index->stabList[s]) == C1));
+    return (found);
+  }
+
   s = 0;
   while ((!found) && (s<pig->intervalNum)) {
     found = ((pig_GetIntervalC0(pig, s) == C0) &&
@@ -1647,6 +2458,8 @@ BOOL pig_CheckInterval(pIntervalGraph_t pig, int C0, int C1) {
 void pig_RemoveVertex(pIntervalGraph_t pig, int idx, BOOL vType) {
   int i, lab_exit;
   int minval, maxval, nextIdx;
+  int slot, rec;
+  pigIndex_t ix;
   BOOL found;
   
 #ifdef DEBUG_PRINT
@@ -1673,6 +2486,49 @@ void pig_RemoveVertex(pIntervalGraph_t pig, int idx, BOOL vType) {
     /* If we are the last exit vertex with this label, remove Interval arcs
        aimed at us */
 
+    ix = pig->index;
+    if (ix != (pigIndex_t)NULL) {
+      /* Only intervals ending at our label can change; shrinking one
+	 makes it end at a neighbouring label, so record it there */
+      slot = pig_IndexLabelSlot(ix, lab_exit, FALSE);
+      if (slot < 0) {
+	fprintf(errfile,"PE%3d: ERROR: pig_RemoveVertex() label %d not indexed\n",
+		MYNODE, lab_exit);
+	break;
+      }
+      ix->labelLive[slot]--;
+      if (ix->labelLive[slot] > 0)
+	break;
+      rec = ix->labelRef[slot];
+      while (rec >= 0) {
+	i = ix->refInt[rec];
+	pig_GetInterval(pig, i, &minval, &maxval, &nextIdx);
+	if ((minval <= lab_exit) && (lab_exit <= maxval)) {
+	  if (minval == maxval) {
+	    pig_SetIntervalC0(pig, i, -1);
+	    pig_SetIntervalC1(pig, i, -1);
+	    pig_IndexUpdateC1(pig, i);
+	    pig->deadInt++;
+	  }
+	  else {
+	    if (minval == lab_exit) {
+	      pig_SetIntervalC0(pig, i, minval+1);
+	      pig_IndexAddRef(ix, minval+1, i);
+	    }
+	    else {
+	      if (maxval == lab_exit) {
+		pig_SetIntervalC1(pig, i, maxval-1);
+		pig_IndexUpdateC1(pig, i);
+		pig_IndexAddRef(ix, maxval-1, i);
+	      }
+	    }
+	  }
+	}
+	rec = ix->refNext[rec];
+      }
+      break;
+    }
+
     found = FALSE;
     i=0;
     while ((i<pig->exitNum) && (!found)) {
@@ -1711,120 +2567,236 @@ void pig_RemoveVertex(pIntervalGraph_t pig, int idx, BOOL vType) {
 
 
 void pig_CleanUp(pIntervalGraph_t pig) {
-  /* Merge in the new Intervals and delete all vertices with marked labels */
-  pIntervalGraph_t pigNew;
-  int vIdx, i;
+  /* Delete all vertices with marked labels.  The intervals are shared
+     chains and are all kept, so the live records slide down in place and
+     the interval block follows them. */
+  int i, k, vs;
+  int newEntr, newExit, newInts;
 
-  pigNew = (pIntervalGraph_t)SAFE_MALLOC(sizeof(struct pIntervalGraph_s),
-					 "(cycle.c) pigNew");
-  
-  pigNew->entrNum = pig->entrNum - pig->deadEntr;
-  pigNew->exitNum = pig->exitNum - pig->deadExit;
-  pigNew->intervalNum = pig->intervalNum;
+  vs = pig_GetVSize();
 
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: dead entr: %3d dead exit: %3d dead int: %3d \n",
 	  MYNODE, pig->deadEntr, pig->deadExit, pig->deadInt);
 #endif
 
-  pig_Init(pigNew);
-
-  /* CHECK */
-
   /* Entrance Vertices */
-  vIdx = 0;
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu Entrance vertices (num %d)\n",MYNODE, pig->entrNum);
-#endif
+  k = 0;
   for (i=0 ; i<pig->entrNum ; i++) {
     if (pig->deadEntrMask[i] == FALSE) {
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu working on idx: %d (label: %d)\n",MYNODE,
-	  i, pig_GetLabel(pig, i, ENTRV));
-#endif
-      pig_SetLabel  (pigNew, vIdx, ENTRV, pig_GetLabel  (pig, i, ENTRV));
-      pig_SetAdj    (pigNew, vIdx, ENTRV, pig_GetAdj    (pig, i, ENTRV));
-      pig_SetAdjAssn(pigNew, vIdx, ENTRV, pig_GetAdjAssn(pig, i, ENTRV));
-      pig_SetIntervalIndex(pigNew, vIdx, ENTRV,
-			   pig_GetIntervalIndex(pig, i, ENTRV));
-      vIdx++;
+      if (k != i)
+	memmove(pig->data + k*vs, pig->data + i*vs, vs*sizeof(int));
+      k++;
     }
   }
-
-  if (vIdx != pigNew->entrNum)
-    fprintf(errfile,"PE%3d: ERROR: vIdx (%d) != pigNew->entrNum (%d)\n",
-	    MYNODE, vIdx, pigNew->entrNum);
-
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu entrance done\n",MYNODE);
-#endif
+  newEntr = k;
 
   /* Exit Vertices */
-  vIdx   = 0;
-
+  k = 0;
   for (i=0 ; i<pig->exitNum ; i++) {
     if (pig->deadExitMask[i] == FALSE) {
-      pig_SetLabel  (pigNew, vIdx, EXITV, pig_GetLabel  (pig, i, EXITV));
-      pig_SetAdj    (pigNew, vIdx, EXITV, pig_GetAdj    (pig, i, EXITV));
-      pig_SetAdjAssn(pigNew, vIdx, EXITV, pig_GetAdjAssn(pig, i, EXITV));
-      pig_SetIntervalIndex(pigNew, vIdx, EXITV,
-			   pig_GetIntervalIndex(pig, i, EXITV));
-      vIdx++;
+      memmove(pig->data + (newEntr + k)*vs,
+	      pig->data + (pig->entrNum + i)*vs, vs*sizeof(int));
+      k++;
     }
   }
+  newExit = k;
 
-  if (vIdx != pigNew->exitNum)
-    fprintf(errfile,"PE%3d: ERROR: vIdx (%d) != pigNew->exitNum (%d)\n",
-	    MYNODE, vIdx, pigNew->exitNum);
+  if ((newEntr != pig->entrNum - pig->deadEntr) ||
+      (newExit != pig->exitNum - pig->deadExit))
+    fprintf(errfile,"PE%3d: ERROR: pig_CleanUp() kept %d entr %d exit, expected %d %d\n",
+	    MYNODE, newEntr, newExit,
+	    pig->entrNum - pig->deadEntr, pig->exitNum - pig->deadExit);
 
 #ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu exit done (num: %d) \n",MYNODE, pig->exitNum);
+  fprintf(outfile,"PE%3d: Copying over %d intervals\n",MYNODE, pig->intervalNum);
 #endif
 
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: Copying over %d intervals\n",MYNODE, pigNew->intervalNum);
-#endif
+  memmove(pig->data + (newEntr + newExit)*vs,
+	  pig->data + (pig->entrNum + pig->exitNum)*vs,
+	  pig->intervalNum * pig_GetISize() * sizeof(int));
 
-  memcpy(pigNew->data + (pigNew->entrNum + pigNew->exitNum)*pig_GetVSize(),
-	 pig->data + (pig->entrNum + pig->exitNum)*pig_GetVSize(),
-	 pigNew->intervalNum * pig_GetISize() * sizeof(int));
+  pig->entrNum = newEntr;
+  pig->exitNum = newExit;
+  newInts = pig_GetDataInInts(pig);
+  pig->data = (int *)realloc(pig->data, (newInts > 0 ? newInts : 1)*sizeof(int));
+  if (pig->data == (int *)NULL)
+    fprintf(errfile,"PE%3d: ERROR: realloc failed in pig_CleanUp\n",
+	    MYNODE);
 
-  /* Swap in new data and parameters */
-  free(pig->data);
-  pig->entrNum  = pigNew->entrNum;
-  pig->exitNum  = pigNew->exitNum;
-  pig->intervalNum   = pigNew->intervalNum;
-  pig->data     = pigNew->data;
-#if 1
-  pigNew->data  = (int *)NULL;
-#endif
-  pig->deadEntr = pigNew->deadEntr;
-  pig->deadExit = pigNew->deadExit;
-  pig->deadInt  = pigNew->deadInt;
-  
-  pig->deadEntrMask = (BOOL *)SAFE_MALLOC(pig->entrNum * sizeof(BOOL),
-					  "(cycle.c) pig->deadEntrMask");
+  /* The masks only shrink, so clear the live prefix and reuse them */
+  pig->deadEntr = 0;
+  pig->deadExit = 0;
+  pig->deadInt  = 0;
   for (i=0 ; i<pig->entrNum ; i++)
     *(pig->deadEntrMask + i) = FALSE;
-
-  pig->deadExitMask = (BOOL *)SAFE_MALLOC(pig->exitNum * sizeof(BOOL),
-					  "(cycle.c) pig->deadExitMask");
   for (i=0 ; i<pig->exitNum ; i++)
     *(pig->deadExitMask + i) = FALSE;
 
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu swapped data structure\n",MYNODE);
-#endif
+  return;
+}
 
-  Free_IntervalPack(pigNew);
-  
-#ifdef DEBUG_PRINT
-  fprintf(outfile,"PE%3d: cu Freed IntervalPack\n",MYNODE);
-#endif
 
+/*************************************************************************/
+/* Dead-end pruning.  An interval holds an exit if the exit's label lies */
+/* in [C0, C1]; an entrance reaches whatever the intervals along its     */
+/* chain hold.  Each sweep finds, against the sorted live exit labels,   */
+/* the intervals that hold an exit, spreads that back along the chains,  */
+/* drops the entrances whose chain holds none, then walks the chains of  */
+/* the rest and drops the exits they never reach.  Sweeps repeat until   */
+/* one removes nothing.  Intervals are shared and are left untouched.    */
+/*************************************************************************/
+
+int pig_LowerBound(int *a, int n, int key) {
+  /* First position in sorted a[0..n-1] holding a value >= key */
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = n;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (a[mid] < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return (lo);
+}
+
+void pig_RemoveOrphans(pIntervalGraph_t pig, int h) {
+  /* After stage h's eliminations, any live entrance whose paired exit
+     lies inside the merged group lost that exit to pruning */
+  int i;
+
+  for (i=0 ; i<pig->entrNum ; i++)
+    if ((pig->deadEntrMask[i] == FALSE) &&
+	(clearLastB(pig_GetAdjAssn(pig, i, ENTRV), h) == MERGENODE))
+      pig_RemoveVertex(pig, i, ENTRV);
   return;
 }
 
+int pig_Prune(pIntervalGraph_t pig) {
+  /* Remove dead-end vertices, returning the number removed */
+  int *labels, *reach, *lo, *hi, *revFirst, *revNext, *queue;
+  BOOL *covered, *visited;
+  int n, i, j, k, C0, C1, nextIdx, qHead, qTail, removed, swept;
+
+  labels   = (int *)SAFE_MALLOC((pig->exitNum+1)*sizeof(int),
+				"(cycleInterval.c) labels");
+  reach    = (int *)SAFE_MALLOC((pig->exitNum+1)*sizeof(int),
+				"(cycleInterval.c) reach");
+  lo       = (int *)SAFE_MALLOC((pig->intervalNum+1)*sizeof(int),
+				"(cycleInterval.c) lo");
+  hi       = (int *)SAFE_MALLOC((pig->intervalNum+1)*sizeof(int),
+				"(cycleInterval.c) hi");
+  revFirst = (int *)SAFE_MALLOC((pig->intervalNum+1)*sizeof(int),
+				"(cycleInterval.c) revFirst");
+  revNext  = (int *)SAFE_MALLOC((pig->intervalNum+1)*sizeof(int),
+				"(cycleInterval.c) revNext");
+  queue    = (int *)SAFE_MALLOC((pig->intervalNum+1)*sizeof(int),
+				"(cycleInterval.c) queue");
+  covered  = (BOOL *)SAFE_MALLOC((pig->intervalNum+1)*sizeof(BOOL),
+				 "(cycleInterval.c) covered");
+  visited  = (BOOL *)SAFE_MALLOC((pig->intervalNum+1)*sizeof(BOOL),
+				 "(cycleInterval.c) visited");
+
+  /* Intervals pointing at each interval, which do not change here */
+  for (j=0 ; j<pig->intervalNum ; j++)
+    revFirst[j] = -1;
+  for (j=0 ; j<pig->intervalNum ; j++) {
+    nextIdx = pig_GetIntervalNext(pig, j);
+    if (nextIdx >= 0) {
+      revNext[j] = revFirst[nextIdx];
+      revFirst[nextIdx] = j;
+    }
+  }
+
+  removed = 0;
+  do {
+    swept = 0;
+
+    n = 0;
+    for (i=0 ; i<pig->exitNum ; i++)
+      if (pig->deadExitMask[i] == FALSE)
+	labels[n++] = pig_GetLabel(pig, i, EXITV);
+    qsort(labels, n, sizeof(int), intCompare);
+    for (i=0 ; i<=n ; i++)
+      reach[i] = 0;
+
+    /* Live exit labels held by each interval are labels[lo..hi-1] */
+    qTail = 0;
+    for (j=0 ; j<pig->intervalNum ; j++) {
+      pig_GetInterval(pig, j, &C0, &C1, &nextIdx);
+      lo[j] = hi[j] = 0;
+      if ((C0 >= 0) && (C0 <= C1)) {
+	lo[j] = pig_LowerBound(labels, n, C0);
+	hi[j] = pig_LowerBound(labels, n, C1+1);
+      }
+      covered[j] = (lo[j] < hi[j]);
+      visited[j] = FALSE;
+      if (covered[j])
+	queue[qTail++] = j;
+    }
+
+    /* An interval is covered if its chain reaches one that holds an exit */
+    qHead = 0;
+    while (qHead < qTail) {
+      j = queue[qHead++];
+      for (k=revFirst[j] ; k>=0 ; k=revNext[k]) {
+	if (!covered[k]) {
+	  covered[k] = TRUE;
+	  queue[qTail++] = k;
+	}
+      }
+    }
+
+    for (i=0 ; i<pig->entrNum ; i++) {
+      if (pig->deadEntrMask[i] == TRUE)
+	continue;
+      j = pig_GetIntervalIndex(pig, i, ENTRV);
+      if ((j < 0) || !covered[j]) {
+	pig_RemoveVertex(pig, i, ENTRV);
+	swept++;
+	continue;
+      }
+      /* Walk the rest of the chain, marking the labels it holds */
+      while ((j >= 0) && !visited[j]) {
+	visited[j] = TRUE;
+	if (lo[j] < hi[j]) {
+	  reach[lo[j]]++;
+	  reach[hi[j]]--;
+	}
+	j = pig_GetIntervalNext(pig, j);
+      }
+    }
+
+    for (i=1 ; i<n ; i++)
+      reach[i] += reach[i-1];
+    for (i=0 ; i<pig->exitNum ; i++) {
+      if (pig->deadExitMask[i] == TRUE)
+	continue;
+      k = pig_LowerBound(labels, n, pig_GetLabel(pig, i, EXITV));
+      if (reach[k] == 0) {
+	pig->deadExit++;
+	pig->deadExitMask[i] = TRUE;
+	swept++;
+      }
+    }
+
+    removed += swept;
+  } while (swept > 0);
+
+  free(visited);
+  free(covered);
+  free(queue);
+  free(revNext);
+  free(revFirst);
+  free(hi);
+  free(lo);
+  free(reach);
+  free(labels);
+  return (removed);
+}
 
 void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
   /* Merge p1 into p0 */
@@ -1835,11 +2807,12 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
   int i;
   int curAdjAssn, origAdjAssn;
   int exit0, exit0Idx, entr1, entr1Idx;
+  int stageNum;
   int intIdx, intOffset;
 
-  BOOL *mark;
+  pigIndex_t ix;
   BOOL seenLoop;
-  int j, C0, C1, nextIdx, entr1intIdx;
+  int j, s, stabNum, C0, C1, nextIdx, entr1intIdx;
     
   p0 = *p0Ptr;
   
@@ -1871,15 +2844,11 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
   memcpy(ptr, loc1, siz*sizeof(int));
   ptr += siz;
 
-  siz   = p0->exitNum*pig_GetVSize();
+  /* Exits of this stage come first */
+  stageNum = pig_MergeExits(pTemp, p0, p1, h);
+  ptr  += (p0->exitNum + p1->exitNum)*pig_GetVSize();
   loc0 += p0->entrNum*pig_GetVSize();
-  memcpy(ptr, loc0 , siz*sizeof(int));
-  ptr += siz;
-
-  siz   = p1->exitNum*pig_GetVSize();
   loc1 += p1->entrNum*pig_GetVSize();
-  memcpy(ptr, loc1, siz*sizeof(int));
-  ptr += siz;
   
   siz   = p0->intervalNum*pig_GetISize();
   loc0 += p0->exitNum*pig_GetVSize();
@@ -1905,6 +2874,7 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
       pig_SetIntervalNext(pTemp, i, intIdx + intOffset);
   }
 
+  pig_BuildIndex(pTemp);
 
 #ifdef DEBUG_PRINT
   fprintf(outfile,"PE%3d: MY P0  MERGE\n",MYNODE);
@@ -1923,10 +2893,9 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
 #endif
 
   /****** MERGE HERE ********/
-  mark = (BOOL *)SAFE_MALLOC(pTemp->intervalNum * sizeof(BOOL),
-			     "(cycleInterval.c) mark");
+  ix = pTemp->index;
 
-  for (i=0 ; i<pTemp->exitNum ; i++) {
+  for (i=0 ; i<stageNum ; i++) {
     exit0Idx = i;
     origAdjAssn = pig_GetAdjAssn(pTemp, exit0Idx, EXITV);
     curAdjAssn  = clearLastB(origAdjAssn, h);
@@ -1934,7 +2903,7 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
     fprintf(outfile,"PE%3d: h: %d orig: %d cur: %d\n",
 	    MYNODE, h, origAdjAssn, curAdjAssn);
 #endif
-    if (curAdjAssn == MYNODE) {
+    if (curAdjAssn == MERGENODE) {
       /* we have a winner */
 
       /* must locate the set of entrance vertices pointing to us,
@@ -1951,8 +2920,9 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
       /* entr1 = label of the entrance vertex we point to */
       entr1     = pig_GetAdj    (pTemp, exit0Idx, EXITV);
 
-      /* entr1Idx,ENTRV = index of the entrance vertex */
-      entr1Idx  = pig_GetEntrIdx(pTemp, entr1, exit0);
+      /* entr1Idx,ENTRV = index of the entrance vertex, or -1 if it was
+	 pruned as a dead end, in which case exit0 leads nowhere */
+      entr1Idx  = pig_FindEntrIdx(pTemp, entr1, exit0);
 #ifdef DEBUG_PRINT
       fprintf(outfile,"PE%3d: h: %d orig: %d cur: %d exit0: %3d entr1: %3d entr1Idx: %3d\n",
 	    MYNODE, h, origAdjAssn, curAdjAssn, exit0, entr1, entr1Idx);
@@ -1960,7 +2930,7 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
 
       /* If the Interval arc exists from entr1 to exit0, we have a cycle! */
 
-      if (pig_CheckArcHead(pTemp, entr1Idx, exit0)) {
+      if ((entr1Idx >= 0) && pig_CheckArcHead(pTemp, entr1Idx, exit0)) {
 	fprintf(outfile,"PE%3d: HALT: CYCLE DETECTED DURING MERGE (%3d, %3d)\n",
 		MYNODE, exit0, entr1);
 	CYCLE_FOUND = TRUE;
@@ -1972,113 +2942,334 @@ void IntervalMerge(pIntervalGraph_t *p0Ptr, pIntervalGraph_t p1, int h) {
 	 the new interval contained in one of these, then add it as new, and
 	 point the last index to it */
 	 
-      entr1intIdx = pig_GetIntervalIndex(pTemp, entr1Idx, ENTRV);
-
-      for (j=0 ; j<pTemp->intervalNum ; j++)
-	mark[j] = FALSE;
-
-      for (j=0 ; j<pTemp->intervalNum ; j++) {
-	if (!mark[j]) {
-	  mark[j] = TRUE;
+      entr1intIdx = (entr1Idx < 0) ? -1 :
+	pig_GetIntervalIndex(pTemp, entr1Idx, ENTRV);
+
+      /* Visit the intervals holding exit0 in index order.  An interval is
+	 treated as already seen if it has a lower index than the one the
+	 trace started from, or was reached by an earlier trace. */
+      ix->epoch++;
+      stabNum = (entr1intIdx < 0) ? 0 : pig_IndexStab(pTemp, exit0);
+
+      for (s=0 ; s<stabNum ; s++) {
+	j = ix->stabList[s];
+	if (ix->stamp[j] != ix->epoch) {
+	  ix->stamp[j] = ix->epoch;
 	  intIdx = j;
 	  pig_GetInterval(pTemp, intIdx, &C0, &C1, &nextIdx);
-	  if ((C0 <= exit0) && (exit0 <= C1)) {
-
-	    seenLoop = FALSE;
-	    while ((intIdx != entr1intIdx)  && (nextIdx >= 0) && !seenLoop) {
-	      intIdx = nextIdx;
-	      if (mark[intIdx])
-		seenLoop = TRUE;
-	      else {
-		mark[intIdx] = TRUE;
-		pig_GetInterval(pTemp, intIdx, &C0, &C1, &nextIdx);
-	      }
-	      
+
+	  seenLoop = FALSE;
+	  while ((intIdx != entr1intIdx)  && (nextIdx >= 0) && !seenLoop) {
+	    intIdx = nextIdx;
+	    if ((intIdx <= j) || (ix->stamp[intIdx] == ix->epoch))
+	      seenLoop = TRUE;
+	    else {
+	      ix->stamp[intIdx] = ix->epoch;
+	      pig_GetInterval(pTemp, intIdx, &C0, &C1, &nextIdx);
 	    }
+	  }
 
-	    if ((nextIdx < 0) && (intIdx != entr1intIdx) && !seenLoop) {
-	      pig_SetIntervalNext(pTemp, intIdx, entr1intIdx);
+	  if ((nextIdx < 0) && (intIdx != entr1intIdx) && !seenLoop) {
+	    pig_LinkInterval(pTemp, intIdx, entr1intIdx);
 #ifdef DEBUG_PRINT
-	      fprintf(outfile,"PE%3d: (%d -> %d) Linking interval %3d -> %3d\n",
-		      MYNODE, exit0, entr1, intIdx, entr1intIdx);
+	    fprintf(outfile,"PE%3d: (%d -> %d) Linking interval %3d -> %3d\n",
+		    MYNODE, exit0, entr1, intIdx, entr1intIdx);
 #endif
-	    }
-	  
 	  }
 	}
       }
       
       pig_RemoveVertex(pTemp, exit0Idx, EXITV);
-      pig_RemoveVertex(pTemp, entr1Idx, ENTRV);
+      if (entr1Idx >= 0)
+	pig_RemoveVertex(pTemp, entr1Idx, ENTRV);
 	 
-    } /* (curAdjAssn  == MYNODE) */
+    } /* (curAdjAssn  == MERGENODE) */
 
   } /* foreach exit0 */
 
+#if PRUNE_DEADENDS
+  pig_RemoveOrphans(pTemp, h);
+#endif
+  pig_FreeIndex(pTemp);
   pig_CleanUp(pTemp);
+#if PRUNE_DEADENDS
+  if (pig_Prune(pTemp) > 0)
+    pig_CleanUp(pTemp);
+#endif
   
 #ifdef DEBUG_PRINT
   Print_myIntervalPack(pTemp);
 #endif
 
-  free(mark);
-  
   *p0Ptr = pTemp;
 
   Free_IntervalPack(p0);
   return;
 }
 
+int Merge_FanInLog(int maxBytes) {
+  /* log2 of the fan-in for the next stage, given the largest pack */
+  int b;
+
+  b = MERGE_FANIN_LOG;
+  while ((b > 1) &&
+	 (2.0 * (double)(1<<b) * (double)maxBytes > (double)MERGE_FANIN_MAXBYTES))
+    b--;
+  return (b);
+}
+
+void Merge_Plan(pIntervalGraph_t pig) {
+  /* Place the ranks at the leaves of the merge tree and renumber the
+     pack's adjAssn fields as tree positions.  Every rank gathers the
+     nonzero trans-arc counts between rank pairs, as (count, r, s)
+     records, and builds the same tree bottom up: at each level the
+     clusters are paired by greedy heavy-edge matching, heaviest
+     boundary first, and the second of a pair is shifted into the upper
+     half of the pair's block.  Clusters left with no neighbour to pair
+     with are paired in index order, so with no preference the pairs
+     come out as the rank-bit ones. */
+  int *pos;
+  int logp, size, i, r;
+#if MERGE_HEAVYEDGE
+  int *cnt, *edgeNum, *edgeOff, *edges, *pairs, *clus, *mate, *newIdx;
+  int eNum, myNum, pNum, c, cNew, L, a, b, k;
+#endif
+
+  logp = log2_i(NODES);
+  size = 1<<logp;
+
+  mergeRank = (int *)SAFE_MALLOC(size*sizeof(int), "(cycleInterval.c) mergeRank");
+  pos       = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleInterval.c) pos");
+  for (r=0 ; r<NODES ; r++)
+    pos[r] = r;
+
+#if MERGE_HEAVYEDGE
+  cnt     = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleInterval.c) cnt");
+  edgeNum = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleInterval.c) edgeNum");
+  edgeOff = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleInterval.c) edgeOff");
+  clus    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleInterval.c) clus");
+  mate    = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleInterval.c) mate");
+  newIdx  = (int *)SAFE_MALLOC(NODES*sizeof(int), "(cycleInterval.c) newIdx");
+
+  for (r=0 ; r<NODES ; r++)
+    cnt[r] = 0;
+  for (i=0 ; i<pig->exitNum ; i++)
+    cnt[pig_GetAdjAssn(pig, i, EXITV)]++;
+  myNum = 0;
+  for (r=0 ; r<NODES ; r++)
+    if ((r != MYNODE) && (cnt[r] > 0))
+      myNum++;
+
+  MPI_Allgather(&myNum, 1, MPI_INT, edgeNum, 1, MPI_INT, MPI_COMM_WORLD);
+  eNum = 0;
+  for (r=0 ; r<NODES ; r++) {
+    edgeOff[r]  = 3*eNum;
+    eNum       += edgeNum[r];
+    edgeNum[r] *= 3;
+  }
+  edges = (int *)SAFE_MALLOC((3*eNum + 1)*sizeof(int), "(cycleInterval.c) edges");
+  pairs = (int *)SAFE_MALLOC((3*eNum + 1)*sizeof(int), "(cycleInterval.c) pairs");
+
+  /* This rank's nonzero row, sent from pairs */
+  k = 0;
+  for (r=0 ; r<NODES ; r++)
+    if ((r != MYNODE) && (cnt[r] > 0)) {
+      pairs[k++] = cnt[r];
+      pairs[k++] = MYNODE;
+      pairs[k++] = r;
+    }
+  MPI_Allgatherv(pairs, 3*myNum, MPI_INT, edges, edgeNum, edgeOff, MPI_INT,
+		 MPI_COMM_WORLD);
+
+  for (r=0 ; r<NODES ; r++) {
+    clus[r] = r;
+    pos[r]  = 0;
+  }
+  c = NODES;
+  for (L=0 ; L<logp ; L++) {
+    /* Trans arcs between the clusters of this level, both directions
+       summed under (lower, upper) cluster */
+    pNum = 0;
+    for (i=0 ; i<eNum ; i++) {
+      a = clus[edges[3*i+1]];
+      b = clus[edges[3*i+2]];
+      if (a != b) {
+	pairs[3*pNum]   = edges[3*i];
+	pairs[3*pNum+1] = min(a,b);
+	pairs[3*pNum+2] = max(a,b);
+	pNum++;
+      }
+    }
+    qsort(pairs, pNum, 3*sizeof(int), pairCompareEnds);
+    k = 0;
+    for (i=0 ; i<pNum ; i++) {
+      if ((k > 0) &&
+	  (pairs[3*(k-1)+1] == pairs[3*i+1]) &&
+	  (pairs[3*(k-1)+2] == pairs[3*i+2]))
+	pairs[3*(k-1)] += pairs[3*i];
+      else {
+	pairs[3*k]   = pairs[3*i];
+	pairs[3*k+1] = pairs[3*i+1];
+	pairs[3*k+2] = pairs[3*i+2];
+	k++;
+      }
+    }
+    pNum = k;
+    qsort(pairs, pNum, 3*sizeof(int), pairCompareWeight);
+
+    for (i=0 ; i<c ; i++)
+      mate[i] = -1;
+    for (i=0 ; i<pNum ; i++) {
+      a = pairs[3*i+1];
+      b = pairs[3*i+2];
+      if ((mate[a] < 0) && (mate[b] < 0)) {
+	mate[a] = b;
+	mate[b] = a;
+      }
+    }
+    /* The rest share no trans arcs with each other: pair them in
+       index order */
+    a = -1;
+    for (i=0 ; i<c ; i++)
+      if (mate[i] < 0) {
+	if (a < 0)
+	  a = i;
+	else {
+	  mate[a] = i;
+	  mate[i] = a;
+	  a = -1;
+	}
+      }
+
+    /* A pair's lower cluster keeps its positions and leads the merge;
+       an odd cluster out waits for the next level with an empty half */
+    cNew = 0;
+    for (i=0 ; i<c ; i++)
+      if ((mate[i] < 0) || (i < mate[i])) {
+	newIdx[i] = cNew;
+	if (mate[i] >= 0)
+	  newIdx[mate[i]] = cNew;
+	cNew++;
+      }
+    for (r=0 ; r<NODES ; r++) {
+      a = clus[r];
+      if ((mate[a] >= 0) && (mate[a] < a))
+	pos[r] += 1<<L;
+      clus[r] = newIdx[a];
+    }
+    c = cNew;
+  }
+
+  free(pairs);
+  free(edges);
+  free(newIdx);
+  free(mate);
+  free(clus);
+  free(edgeOff);
+  free(edgeNum);
+  free(cnt);
+#endif
+
+  for (i=0 ; i<size ; i++)
+    mergeRank[i] = -1;
+  for (r=0 ; r<NODES ; r++)
+    mergeRank[pos[r]] = r;
+  MERGENODE = pos[MYNODE];
+
+#ifdef DEBUG_PRINT
+  if (MYNODE==0)
+    for (i=0 ; i<size ; i++)
+      fprintf(outfile,"PE%3d: merge position %3d: rank %3d\n",
+	      MYNODE, i, mergeRank[i]);
+#endif
+
+  /* From here on adjAssn holds a tree position; the pack is compact */
+  for (i=0 ; i<pig->entrNum ; i++)
+    pig_SetAdjAssn(pig, i, ENTRV, pos[pig_GetAdjAssn(pig, i, ENTRV)]);
+  for (i=0 ; i<pig->exitNum ; i++)
+    pig_SetAdjAssn(pig, i, EXITV, pos[pig_GetAdjAssn(pig, i, EXITV)]);
+  pig_SortExitsByStage(pig);
+
+  free(pos);
+  return;
+}
+
 void Merge_IntervalPack(pIntervalGraph_t *pig) {
-  int h;
+  int h, lo, j, from, num;
   int logp;
-  pIntervalGraph_t pIntervalGraph_recv;
-  int found, result;
+  pIntervalGraph_t *pRecv, pCat;
+  int stat[2], result[2];
 
   /* logp is the ceiling of log2(NODES) */
   logp = log2_i(NODES);
-  for (h=0 ; h<logp ; h++) {
+  Merge_Plan(*pig);
+  pRecv = (pIntervalGraph_t *)SAFE_MALLOC((1<<MERGE_FANIN_LOG)*sizeof(pIntervalGraph_t),
+					  "(cycleInterval.c) pRecv");
+
+  stat[0] = 0;
+  stat[1] = pig_GetDataInBytes(*pig);
+  MPI_Allreduce(stat, result, 2, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+  /* Each pass covers binary stages lo..h, merging the group of tree
+     positions that differ only in those bits onto the one with them all
+     clear */
+  for (lo=0 ; lo<logp ; lo=h+1) {
+    h = min(lo + Merge_FanInLog(result[1]), logp) - 1;
 #if PRINT_MERGESIZE
     MPI_Barrier(MPI_COMM_WORLD);
 #endif
-    if (lastB(MYNODE, h)==0) {
+    stat[1] = 0;
+    if (lastB(MERGENODE, lo)==0) {
 #if PRINT_MERGESIZE
       fprintf(outfile,"PE%3d: [%3d] entr: %12d exit: %12d exarcs: %12d\n",
-	      MYNODE, h, (*pig)->entrNum, (*pig)->exitNum, (*pig)->arcNum);
+	      MYNODE, h, (*pig)->entrNum, (*pig)->exitNum, (*pig)->intervalNum);
 #endif
-      if (testB(MYNODE,h)==0) {
-	/* Make sure that if we're not using a power-of-two nodes
-	   that we just sit idle for a stage where our partner is missing */
-	if (setB(MYNODE,h) < NODES) {
+      if (clearLastB(MERGENODE, h) == MERGENODE) {
+	/* Positions left empty when NODES is not a power of two are
+	   skipped; with none filled we sit idle this stage */
+	num = 0;
+	for (j=1 ; j<(1<<(h-lo+1)) ; j++) {
+	  from = mergeRank[MERGENODE + (j<<lo)];
+	  if (from >= 0) {
 #ifdef DEBUG_PRINT
-	  fprintf(outfile,"PE%3d: (h:%3d) I'm receiving from PE%3d\n",
-		  MYNODE, h, setB(MYNODE,h));
-	  fflush(outfile);
+	    fprintf(outfile,"PE%3d: (h:%3d) I'm receiving from PE%3d\n",
+		    MYNODE, h, from);
+	    fflush(outfile);
 #endif
-	  Recv_IntervalPack(&pIntervalGraph_recv, setB(MYNODE,h));
-	  IntervalMerge(pig, pIntervalGraph_recv, h);
-
-	  Free_IntervalPack(pIntervalGraph_recv);
+	    Recv_IntervalPack(pRecv + num, from);
+	    num++;
+	  }
 	}
+	if (num > 0) {
+	  if (num == 1)
+	    pCat = pRecv[0];
+	  else {
+	    pCat = pig_ConcatPacks(pRecv, num);
+	    for (j=0 ; j<num ; j++)
+	      Free_IntervalPack(pRecv[j]);
+	  }
+	  IntervalMerge(pig, pCat, h);
+	  Free_IntervalPack(pCat);
+	}
+	stat[1] = pig_GetDataInBytes(*pig);
       }
       else {
 #ifdef DEBUG_PRINT
 	fprintf(outfile,"PE%3d: (h:%3d) I'm sending to PE%3d\n",
-		MYNODE, h, clearB(MYNODE,h));
+		MYNODE, h, mergeRank[clearLastB(MERGENODE, h)]);
 	fflush(outfile);
 #endif
-	Send_IntervalPack(*pig, clearB(MYNODE,h));
+	Send_IntervalPack(*pig, mergeRank[clearLastB(MERGENODE, h)]);
       }
     }
-#if 1
-    found = (CYCLE_FOUND==TRUE)?1:0;
-    MPI_Allreduce(&found, &result, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
-    if (result)
-      return;
-#else
-    MPI_Barrier(MPI_COMM_WORLD);
-#endif
+    /* A cycle anywhere, and the largest pack left for the next stage */
+    stat[0] = (CYCLE_FOUND==TRUE)?1:0;
+    MPI_Allreduce(stat, result, 2, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (result[0])
+      break;
   }
+  free(pRecv);
+  free(mergeRank);
   return;
 }
 
@@ -2110,15 +3301,19 @@ void main(int argc, char **argv) {
   vertexList_t myVerts;
   int initTransArcCount, termTransArcCount;
   transArc_t *initTransArcs, *termTransArcs;
+#if !DIRECT_PACK
   eGraph_t expGraph;
+#endif
   pIntervalGraph_t pIntervalGraph;
   int found, result;
+  int backArcs;
 
   timer_init();
   
   MPI_Init(&argc, &argv);
   MPI_Comm_rank(MPI_COMM_WORLD, &MYNODE);
   MPI_Comm_size(MPI_COMM_WORLD, &NODES);
+  MERGENODE = MYNODE;
 
   outfile = stdout;
 #if 0
@@ -2162,6 +3357,12 @@ void main(int argc, char **argv) {
   timer_mark("Print Input");
 #endif
 
+  backArcs = 1;
+#if BACKARC_PRUNE
+  backArcs = Backarc_Restrict(myVerts);
+  timer_mark("Backarc_Restrict");
+#endif
+
   Find_Local_Cycles(myVerts,
 		    &initTransArcCount,
 		    &initTransArcs);
@@ -2169,7 +3370,7 @@ void main(int argc, char **argv) {
 
   found = (CYCLE_FOUND==TRUE)?1:0;
   MPI_Allreduce(&found, &result, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
-  if (!result) {
+  if ((!result) && (backArcs > 0)) {
   
     Discovery(myVerts,
 	      initTransArcCount, 
@@ -2178,6 +3379,15 @@ void main(int argc, char **argv) {
 	      &termTransArcs);
     timer_mark("Discovery");
 
+#if DIRECT_PACK
+    Create_IntervalPack_Direct(myVerts,
+			       initTransArcCount,
+			       initTransArcs,
+			       termTransArcCount,
+			       termTransArcs,
+			       &pIntervalGraph);
+    timer_mark("Create_IntervalPack");
+#else
     Create_Express(myVerts,
 		   initTransArcCount, 
 		   initTransArcs,
@@ -2193,6 +3403,13 @@ void main(int argc, char **argv) {
     
     Create_IntervalPack(expGraph, &pIntervalGraph);
     timer_mark("Create_IntervalPack");
+#endif
+
+#if PRUNE_DEADENDS
+    if (pig_Prune(pIntervalGraph) > 0)
+      pig_CleanUp(pIntervalGraph);
+    timer_mark("Prune_IntervalPack");
+#endif
 
 #ifdef DEBUG_PRINT
     Print_IntervalPack(pIntervalGraph);
@@ -2204,7 +3421,9 @@ void main(int argc, char **argv) {
     
     Free_IntervalPack(pIntervalGraph);
     
+#if !DIRECT_PACK
     Free_Express(expGraph);
+#endif
     free(termTransArcs);
   }
 
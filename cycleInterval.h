@@ -117,6 +117,34 @@ typedef struct eGraph_s {
 
 /***************************************************************/
 
+/* Lookup tables built over a packed interval graph for one merge */
+typedef struct pigIndex_s {
+  int  labelSize;        /* Size of the label hash table (power of 2) */
+  int  labelNum;         /* Number of labels in the table */
+  int *labelKey;         /* Label held in each slot, -1 if empty */
+  int *labelLive;        /* Number of live exits with this label */
+  int *labelRef;         /* First interval with this label as an endpoint */
+  int  refNum;           /* Number of endpoint records in use */
+  int  refMax;           /* Number of endpoint records allocated */
+  int *refInt;           /* Interval index */
+  int *refNext;          /* Next record for the same label, -1 if none */
+  /* Stabbing queries: intervals sorted by C0, with a max-C1 tree on top */
+  int  treeSize;         /* Number of tree leaves (power of 2) */
+  int *order;            /* Interval indices sorted by C0 at build time */
+  int *orderC0;          /* C0 of each interval in order, at build time */
+  int *orderPos;         /* Position of each interval in order */
+  int *treeC1;           /* Largest current C1 under each node, -1 if none */
+  /* Reverse of the interval chains */
+  int *revFirst;         /* First interval whose next is this one, -1 if none */
+  int *revNext;          /* Next interval with the same next, -1 if none */
+  int *headFirst;        /* First entrance whose chain starts here, -1 if none */
+  int *headNext;         /* Next entrance with the same first interval */
+  int *stamp;            /* Visit marks, current if equal to epoch */
+  int  epoch;
+  int *stabList;         /* Result of pig_IndexStab */
+  int *queue;            /* Work list for pig_GetEntrPred */
+} *pigIndex_t;
+
 typedef struct pIntervalGraph_s {
   int entrNum;           /* Number of entrance vertices */
   int exitNum;           /* Number of exit vertices */
@@ -128,6 +156,7 @@ typedef struct pIntervalGraph_s {
   BOOL *deadEntrMask;
   BOOL *deadExitMask;
   int deadInt;
+  struct pigIndex_s *index; /* Lookup tables, only present during a merge */
 } *pIntervalGraph_t;
 
 /***************************************************************/
@@ -71,6 +71,17 @@ int clearLastB(int z, int h) {
   return (z & ~((1<<(h+1))-1));
 }
 
+int highB(int z) {
+  /* Index of the highest set bit, or -1 if z is 0 */
+  int h;
+  h = -1;
+  while (z != 0) {
+    h++;
+    z = (int)((unsigned int)z >> 1);
+  }
+  return(h);
+}
+
 void transArcCopy(transArc_t *dst, transArc_t *src) {
   /* Deep copy */
   dst->tail = src->tail;
@@ -70,6 +70,7 @@ int setB(int, int);
 int clearB(int, int);
 int testB(int, int);
 int clearLastB(int, int);
+int highB(int);
 
 int log2_i(int);
 